@@ -6,21 +6,23 @@
 #include "cryptopp/modes.h"
 #include "cryptopp/aes.h"
 #include "cryptopp/filters.h"
-#include "cryptopp/osrng.h"
+#include "cryptopp/gcm.h"
+#include "RandomService.h"
 #include <stdexcept>
-#include <immintrin.h>	// _rdrand32_step
+#include <algorithm>
+#include <cstring>
 
 
 unsigned char* AESWrapper::GenerateKey(unsigned char* buffer, unsigned int length)
 {
-    for (size_t i = 0; i < length; i += sizeof(unsigned int))
-        _rdrand32_step(reinterpret_cast<unsigned int*>(&buffer[i]));
+    RandomService::generate(buffer, length);
     return buffer;
 }
 
 AESWrapper::AESWrapper()
 {
     GenerateKey(_key, DEFAULT_KEYLENGTH);
+    setupKeySchedule();
 }
 
 AESWrapper::AESWrapper(const unsigned char* key, unsigned int length)
@@ -28,6 +30,13 @@ AESWrapper::AESWrapper(const unsigned char* key, unsigned int length)
     if (length != DEFAULT_KEYLENGTH)
         throw std::length_error("key length must be 16 bytes");
     CryptoPP::memcpy_s(_key, DEFAULT_KEYLENGTH, key, length);
+    setupKeySchedule();
+}
+
+void AESWrapper::setupKeySchedule()
+{
+    _aesEncryption.SetKey(_key, DEFAULT_KEYLENGTH);
+    _aesDecryption.SetKey(_key, DEFAULT_KEYLENGTH);
 }
 
 AESWrapper::~AESWrapper()
@@ -39,18 +48,21 @@ const unsigned char* AESWrapper::getKey() const
     return _key;
 }
 
+void AESWrapper::generateIV(unsigned char* iv, size_t length)
+{
+    RandomService::generate(iv, length);
+}
+
 std::string AESWrapper::encrypt(const char* plain, unsigned int length)
 {
     // Generate a random IV
     CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE];
-    CryptoPP::AutoSeededRandomPool rng;
-    rng.GenerateBlock(iv, sizeof(iv));
+    generateIV(iv, sizeof(iv));
 
-    CryptoPP::AES::Encryption aesEncryption(_key, DEFAULT_KEYLENGTH);
-    CryptoPP::CBC_Mode_ExternalCipher::Encryption cbcEncryption(aesEncryption, iv);
+    _cbcEncryption.SetCipherWithIV(_aesEncryption, iv);
 
     std::string cipher;
-    CryptoPP::StreamTransformationFilter stfEncryptor(cbcEncryption, new CryptoPP::StringSink(cipher));
+    CryptoPP::StreamTransformationFilter stfEncryptor(_cbcEncryption, new CryptoPP::StringSink(cipher));
     stfEncryptor.Put(reinterpret_cast<const CryptoPP::byte*>(plain), length);
     stfEncryptor.MessageEnd();
 
@@ -58,6 +70,32 @@ std::string AESWrapper::encrypt(const char* plain, unsigned int length)
     return std::string(reinterpret_cast<char*>(iv), CryptoPP::AES::BLOCKSIZE) + cipher;
 }
 
+void AESWrapper::encrypt(std::istream& plain, const std::function<void(const char*, size_t)>& onPlainChunk,
+                         const std::function<void(const char*, size_t)>& onCipherChunk)
+{
+    AESStreamEncryptor encryptor(*this, onCipherChunk);
+
+    // Feed the plain text through the cipher one chunk at a time
+    std::string chunk(STREAM_CHUNK_SIZE, '\0');
+    while (plain) {
+        plain.read(&chunk[0], chunk.size());
+        size_t length = static_cast<size_t>(plain.gcount());
+        if (length == 0)
+            break;
+        onPlainChunk(chunk.data(), length);
+        encryptor.push(chunk.data(), length);
+    }
+    if (!plain.eof())
+        throw std::runtime_error("failed reading plain text stream");
+    encryptor.finish();
+}
+
+// IV prefix plus the PKCS#7 padded plain text (padding always adds between 1 and BLOCKSIZE bytes)
+size_t AESWrapper::cipherLength(size_t plainLength)
+{
+    return CryptoPP::AES::BLOCKSIZE + (plainLength / CryptoPP::AES::BLOCKSIZE + 1) * CryptoPP::AES::BLOCKSIZE;
+}
+
 
 std::string AESWrapper::decrypt(const char* cipher, unsigned int length)
 {
@@ -68,13 +106,103 @@ std::string AESWrapper::decrypt(const char* cipher, unsigned int length)
     CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE];
     memcpy(iv, cipher, CryptoPP::AES::BLOCKSIZE);
 
-    CryptoPP::AES::Decryption aesDecryption(_key, DEFAULT_KEYLENGTH);
-    CryptoPP::CBC_Mode_ExternalCipher::Decryption cbcDecryption(aesDecryption, iv);
+    _cbcDecryption.SetCipherWithIV(_aesDecryption, iv);
 
     std::string decrypted;
-    CryptoPP::StreamTransformationFilter stfDecryptor(cbcDecryption, new CryptoPP::StringSink(decrypted));
+    CryptoPP::StreamTransformationFilter stfDecryptor(_cbcDecryption, new CryptoPP::StringSink(decrypted));
     stfDecryptor.Put(reinterpret_cast<const CryptoPP::byte*>(cipher + CryptoPP::AES::BLOCKSIZE), length - CryptoPP::AES::BLOCKSIZE);
     stfDecryptor.MessageEnd();
 
     return decrypted;
 }
+
+
+void AESWrapper::encryptGcm(const unsigned char* nonce, const unsigned char* aad, size_t aadLength,
+                            const char* plain, size_t length, char* cipher, unsigned char* tag) const
+{
+    CryptoPP::GCM<CryptoPP::AES>::Encryption gcm;
+    gcm.SetKeyWithIV(_key, DEFAULT_KEYLENGTH, nonce, GCM_NONCE_LENGTH);
+    gcm.EncryptAndAuthenticate(reinterpret_cast<CryptoPP::byte*>(cipher), tag, GCM_TAG_LENGTH,
+                               nonce, GCM_NONCE_LENGTH, aad, aadLength,
+                               reinterpret_cast<const CryptoPP::byte*>(plain), length);
+}
+
+bool AESWrapper::decryptGcm(const unsigned char* nonce, const unsigned char* aad, size_t aadLength,
+                            const char* cipher, size_t length, const unsigned char* tag, char* plain) const
+{
+    CryptoPP::GCM<CryptoPP::AES>::Decryption gcm;
+    gcm.SetKeyWithIV(_key, DEFAULT_KEYLENGTH, nonce, GCM_NONCE_LENGTH);
+    return gcm.DecryptAndVerify(reinterpret_cast<CryptoPP::byte*>(plain), tag, GCM_TAG_LENGTH,
+                                nonce, GCM_NONCE_LENGTH, aad, aadLength,
+                                reinterpret_cast<const CryptoPP::byte*>(cipher), length);
+}
+
+AESStreamEncryptor::AESStreamEncryptor(AESWrapper& aes, Sink sink)
+    : _aes(aes), _sink(std::move(sink)), _pendingLength(0), _finished(false)
+{
+    // Generate a random IV and emit it as the cipher text prefix
+    CryptoPP::byte iv[CryptoPP::AES::BLOCKSIZE];
+    _aes.generateIV(iv, sizeof(iv));
+    _aes._cbcEncryption.SetCipherWithIV(_aes._aesEncryption, iv);
+    _sink(reinterpret_cast<const char*>(iv), sizeof(iv));
+}
+
+AESStreamEncryptor::~AESStreamEncryptor()
+{
+}
+
+void AESStreamEncryptor::emitBlocks(const CryptoPP::byte* plain, size_t length)
+{
+    std::string& out = _aes._scratch;
+    if (out.size() < length)
+        out.resize(length);
+    _aes._cbcEncryption.ProcessData(reinterpret_cast<CryptoPP::byte*>(&out[0]), plain, length);
+    _sink(out.data(), length);
+}
+
+void AESStreamEncryptor::push(const char* plain, size_t length)
+{
+    if (_finished)
+        throw std::logic_error("push called after finish");
+
+    const CryptoPP::byte* input = reinterpret_cast<const CryptoPP::byte*>(plain);
+
+    // Complete a block left over from the previous push first
+    if (_pendingLength > 0) {
+        size_t take = std::min(length, CryptoPP::AES::BLOCKSIZE - _pendingLength);
+        memcpy(_pending + _pendingLength, input, take);
+        _pendingLength += take;
+        input += take;
+        length -= take;
+        if (_pendingLength < CryptoPP::AES::BLOCKSIZE)
+            return;
+        emitBlocks(_pending, CryptoPP::AES::BLOCKSIZE);
+        _pendingLength = 0;
+    }
+
+    // Encrypt whole blocks straight from the input, in bounded slices
+    size_t whole = length - length % CryptoPP::AES::BLOCKSIZE;
+    while (whole > 0) {
+        size_t slice = std::min<size_t>(whole, AESWrapper::STREAM_CHUNK_SIZE);
+        emitBlocks(input, slice);
+        input += slice;
+        length -= slice;
+        whole -= slice;
+    }
+
+    memcpy(_pending, input, length);
+    _pendingLength = length;
+}
+
+void AESStreamEncryptor::finish()
+{
+    if (_finished)
+        return;
+
+    // PKCS#7 padding, matching StreamTransformationFilter's default for CBC
+    CryptoPP::byte padding = static_cast<CryptoPP::byte>(CryptoPP::AES::BLOCKSIZE - _pendingLength);
+    memset(_pending + _pendingLength, padding, padding);
+    emitBlocks(_pending, CryptoPP::AES::BLOCKSIZE);
+    _pendingLength = 0;
+    _finished = true;
+}
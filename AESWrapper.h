@@ -5,15 +5,35 @@
 #ifndef DEFENSIVE_MAMAN_15_AESWRAPPER_H
 #define DEFENSIVE_MAMAN_15_AESWRAPPER_H
 #include <string>
+#include <istream>
+#include <functional>
+#include "cryptopp/aes.h"
+#include "cryptopp/modes.h"
 
 
+// The key schedules and CBC mode objects are set up once per key and reused by every encrypt/decrypt
+// call, so a wrapper should live as long as the key it holds (e.g. a whole session). A wrapper runs one operation at a
+// time - it must not be shared between threads.
 class AESWrapper
 {
 public:
     static const unsigned int DEFAULT_KEYLENGTH = 16;
+    static const unsigned int STREAM_CHUNK_SIZE = 1 << 16;
+    static const unsigned int GCM_NONCE_LENGTH = 12;
+    static const unsigned int GCM_TAG_LENGTH = 16;
+
+    static size_t cipherLength(size_t plainLength);
 private:
     unsigned char _key[DEFAULT_KEYLENGTH];
+    CryptoPP::AES::Encryption _aesEncryption;
+    CryptoPP::AES::Decryption _aesDecryption;
+    CryptoPP::CBC_Mode_ExternalCipher::Encryption _cbcEncryption;
+    CryptoPP::CBC_Mode_ExternalCipher::Decryption _cbcDecryption;
+    std::string _scratch;
+
+    friend class AESStreamEncryptor;
     AESWrapper(const AESWrapper& aes);
+    void setupKeySchedule();
 public:
     static unsigned char* GenerateKey(unsigned char* buffer, unsigned int length);
 
@@ -22,9 +42,46 @@ public:
     ~AESWrapper();
 
     const unsigned char* getKey() const;
+    void generateIV(unsigned char* iv, size_t length);
 
     std::string encrypt(const char* plain, unsigned int length);
+    void encrypt(std::istream& plain, const std::function<void(const char*, size_t)>& onPlainChunk,
+                 const std::function<void(const char*, size_t)>& onCipherChunk);
     std::string decrypt(const char* cipher, unsigned int length);
+
+    // Unlike the CBC calls, GCM calls only read the key and may run concurrently from several threads
+    void encryptGcm(const unsigned char* nonce, const unsigned char* aad, size_t aadLength,
+                    const char* plain, size_t length, char* cipher, unsigned char* tag) const;
+    bool decryptGcm(const unsigned char* nonce, const unsigned char* aad, size_t aadLength,
+                    const char* cipher, size_t length, const unsigned char* tag, char* plain) const;
+};
+
+
+// Incremental AES-CBC encryptor: push() plain text in chunks of any size, finish() once at the end. Cipher text is
+// handed to the sink as soon as whole blocks are available, in the same format AESWrapper::encrypt produces (IV
+// prefix, PKCS#7 padding), so memory use is bounded by the chunk size instead of the message size. It runs on the
+// key schedule and mode objects of the AESWrapper it is created from.
+class AESStreamEncryptor
+{
+public:
+    typedef std::function<void(const char*, size_t)> Sink;
+
+private:
+    AESWrapper& _aes;
+    Sink _sink;
+    CryptoPP::byte _pending[CryptoPP::AES::BLOCKSIZE];
+    size_t _pendingLength;
+    bool _finished;
+
+    AESStreamEncryptor(const AESStreamEncryptor& encryptor);
+    AESStreamEncryptor& operator=(const AESStreamEncryptor& encryptor);
+    void emitBlocks(const CryptoPP::byte* plain, size_t length);
+public:
+    AESStreamEncryptor(AESWrapper& aes, Sink sink);
+    ~AESStreamEncryptor();
+
+    void push(const char* plain, size_t length);
+    void finish();
 };
 
 #endif //DEFENSIVE_MAMAN_15_AESWRAPPER_H
@@ -0,0 +1,642 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Run the client's protocol flows as coroutines on an event loop, awaiting socket readiness and offloaded
+ * CPU heavy work where the blocking ProtocolHandler would wait.
+ */
+#include "AsyncProtocolHandler.h"
+#include "CryptoHandler.h"
+#include "RSAKeyFactory.h"
+#include "FileHandler.h"
+#include "AESWrapper.h"
+#include "RSAWrapper.h"
+#include "Base64Wrapper.h"
+#include "WireFormat.h"
+#include "constants.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <system_error>
+#include <utility>
+
+AsyncProtocolHandler::AsyncProtocolHandler(EventLoop& loop, ThreadPool& offloadPool, ThreadPool& segmentPool,
+                                           std::string server_address, int port, std::string name,
+                                           std::vector<std::string> filePaths)
+        : loop_(loop), offloadPool_(offloadPool), segmentPool_(segmentPool), serverAddress_(std::move(server_address)),
+          clientName_(std::move(name)), filePaths_(std::move(filePaths)), port_(port),
+          serverVersion_(PROTOCOL_VERSION), logger_("AsyncProtocolHandler") {}
+
+AsyncProtocolHandler::~AsyncProtocolHandler() {
+    if (socket_ != -1) {
+        loop_.remove(socket_);
+        close(socket_);
+    }
+}
+
+/**
+ * Resumes the flow waiting for the socket. The socket is only watched while a flow waits for it, so the loop runs
+ * exactly as long as some flow is waiting for something - which also tells what it is waiting for, so the events
+ * themselves are ignored.
+ */
+void AsyncProtocolHandler::onEvents(uint32_t) {
+    loop_.remove(socket_);
+    if (std::coroutine_handle<> waiting = std::exchange(waiting_, {})) {
+        waiting.resume();
+    }
+}
+
+/**
+ * Waits for the socket to be ready for the given events.
+ * @param events The events to wait for (EPOLLIN, EPOLLOUT).
+ * @return An awaitable resuming the flow once the socket is ready.
+ */
+AsyncProtocolHandler::Readiness AsyncProtocolHandler::ready(uint32_t events) {
+    return Readiness{*this, events};
+}
+
+void AsyncProtocolHandler::Readiness::await_suspend(std::coroutine_handle<> awaiting) {
+    handler.waiting_ = awaiting;
+    handler.loop_.add(handler.socket_, events, &handler);
+}
+
+/**
+ * Takes the next RSA key pair from the shared key factory.
+ * @return An awaitable resuming the flow with the key pair once the factory handed it over.
+ */
+AsyncProtocolHandler::RSAKeyPairTake AsyncProtocolHandler::takeRSAKeyPair() {
+    return RSAKeyPairTake{*this, {}, nullptr};
+}
+
+void AsyncProtocolHandler::RSAKeyPairTake::await_suspend(std::coroutine_handle<> awaiting) {
+    EventLoop& loop = handler.loop_;
+    loop.retain();
+    RSAKeyFactory::shared().take([this, awaiting, &loop](std::pair<std::string, std::string> taken,
+                                                         std::exception_ptr failure) {
+        keyPair = std::move(taken);
+        error = failure;
+        loop.post([awaiting, &loop]() {
+            loop.release();
+            awaiting.resume();
+        });
+    });
+}
+
+std::pair<std::string, std::string> AsyncProtocolHandler::RSAKeyPairTake::await_resume() {
+    if (error) {
+        std::rethrow_exception(error);
+    }
+    return std::move(keyPair);
+}
+
+/**
+ * Establishes a connection to the server.
+ * @return True if the connection is successful, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::handleConnection() {
+    sockaddr_in server_addr{};
+    socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (socket_ == -1) {
+        logger_.serverError("failed to create a socket");
+        co_return false;
+    }
+
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port_);
+    inet_pton(AF_INET, serverAddress_.c_str(), &server_addr.sin_addr);
+
+    if (connect(socket_, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0) {
+        if (errno != EINPROGRESS) {
+            logger_.serverError("failed to connect to the server");
+            co_return false;
+        }
+        // The socket turns writable once the connection is established (or has failed):
+        co_await ready(EPOLLOUT);
+        int error = 0;
+        socklen_t length = sizeof(error);
+        getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &length);
+        if (error != 0) {
+            logger_.serverError("failed to connect to the server");
+            co_return false;
+        }
+    }
+    co_return true;
+}
+
+/**
+ * Sends a request object to the server. If we were unable to send the message - logging the error, and marking the
+ * connection as lost.
+ * @param request The request object to send.
+ * @return True if the request was sent in full, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::sendRequest(const Request& request) {
+    using namespace WireFormat;
+    iovec parts[2];
+
+    // The fixed-size header, encoded field by field
+    char header[RequestHeader::SIZE];
+    RequestHeader::ClientId::store(header, request.clientId);
+    RequestHeader::Version::store(header, static_cast<uint8_t>(request.version));
+    RequestHeader::Code::store(header, request.code);
+    RequestHeader::PayloadSize::store(header, request.payloadSize);
+    parts[0].iov_base = header;
+    parts[0].iov_len = sizeof(header);
+
+    // The variable-length payload
+    parts[1].iov_base = request.payload;
+    parts[1].iov_len = request.payloadSize;
+
+    // Sending the request to the server:
+    try {
+        co_await sendParts(parts, 2);
+    } catch (const std::exception& e) {
+        logger_.error((std::ostringstream() << "Exception caught in sendRequest: " << e.what()).str());
+        connectionLost_ = true;
+        co_return false;
+    }
+    co_return true;
+}
+
+/**
+ * Sends a sequence of buffers to the server as one contiguous message, waiting for the socket whenever it is full.
+ * @param parts The buffers to send, in order - advanced in place as they are sent.
+ * @param count The number of buffers.
+ * @throws std::system_error If the socket fails.
+ */
+Task<> AsyncProtocolHandler::sendParts(iovec* parts, size_t count) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;  // Report a closed connection as EPIPE instead of raising SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = count;
+    while (message.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(socket_, &message, flags);
+        if (sent == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await ready(EPOLLOUT);
+                continue;
+            }
+            throw std::system_error(errno, std::system_category(), "Failed to send message to server");
+        }
+
+        // Skip the buffers that were sent in full, and the sent prefix of the one that wasn't
+        auto remaining = static_cast<size_t>(sent);
+        while (message.msg_iovlen > 0 && remaining >= message.msg_iov->iov_len) {
+            remaining -= message.msg_iov->iov_len;
+            ++message.msg_iov;
+            --message.msg_iovlen;
+        }
+        if (message.msg_iovlen > 0) {
+            message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + remaining;
+            message.msg_iov->iov_len -= remaining;
+        }
+    }
+}
+
+/**
+ * Receives exactly the requested number of bytes, waiting for the socket whenever nothing has arrived yet.
+ * @param buffer The buffer to receive the data into.
+ * @param length The number of bytes to receive.
+ * @return The number of bytes received - less than length only if the connection was closed or failed.
+ */
+Task<size_t> AsyncProtocolHandler::receiveExactly(char* buffer, size_t length) {
+    size_t received = 0;
+    while (received < length) {
+        ssize_t bytes_received = recv(socket_, buffer + received, length - received, 0);
+        if (bytes_received == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                co_await ready(EPOLLIN);
+                continue;
+            }
+            logger_.error((std::ostringstream() << "recv failed: " << std::strerror(errno)).str());
+            break;
+        }
+        if (bytes_received == 0) {
+            break;  // Connection closed
+        }
+        received += static_cast<size_t>(bytes_received);
+    }
+    co_return received;
+}
+
+/**
+ * Receives and deserializes a response from the server into a Response object. The payload is received into a buffer
+ * kept by the handler and reused by every response, so it is only valid until the next call.
+ * @return The deserialized response object - an empty one (code 0), marking the connection as lost, if the response
+ * was cut short.
+ */
+Task<Response> AsyncProtocolHandler::getResponse() {
+    using namespace WireFormat;
+    Response response{};
+
+    // Receive the fixed-size part of the response
+    char header_buffer[ResponseHeader::SIZE];  // version (1 byte) + code (2 bytes) + payloadSize (4 bytes)
+    size_t bytes_received = co_await receiveExactly(header_buffer, sizeof(header_buffer));
+    if (bytes_received != sizeof(header_buffer)) {
+        logger_.serverError((std::ostringstream() << "Received partial headers data, expected " << sizeof(header_buffer) << "bytes, got " << bytes_received).str());
+        connectionLost_ = true;
+        co_return response;
+    }
+
+    // Deserialize the fixed-size part
+    response.version = char(ResponseHeader::Version::load(header_buffer) + '0');  // Convert to ascii value.
+    serverVersion_ = response.version;
+    response.code = ResponseHeader::Code::load(header_buffer);
+    response.payloadSize = ResponseHeader::PayloadSize::load(header_buffer);
+
+    // Receive the payload based on the payloadSize, growing the receive buffer only if it's too small
+    if (receiveBuffer_.size() < response.payloadSize) {
+        receiveBuffer_.resize(response.payloadSize);
+    }
+    bytes_received = co_await receiveExactly(receiveBuffer_.data(), response.payloadSize);
+    if (bytes_received != response.payloadSize) {
+        logger_.serverError((std::ostringstream() << "Received partial payload, expected " << response.payloadSize << "bytes, got " << bytes_received).str());
+        connectionLost_ = true;
+        co_return Response{};
+    }
+
+    response.payload = std::string_view(receiveBuffer_.data(), response.payloadSize);
+    co_return response;
+}
+
+/**
+ * Sends a CRC status request to the server with the received code.
+ * @param clientId The client's identifier.
+ * @param code The request code.
+ * @return True if the server confirms the message, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::sendCRCStatusRequest(const char* clientId, uint16_t code) {
+    Request file_request{};
+    memcpy(file_request.clientId, clientId, 16);
+    file_request.version = PROTOCOL_VERSION;
+    file_request.code = code;
+
+    PayloadArena::Scope scope(payloadArena_);
+    char* payload_buffer = payloadArena_.allocate(filePath_.length() + 1);
+    std::strcpy(payload_buffer, filePath_.c_str());
+    file_request.payloadSize = filePath_.length() + 1;
+    file_request.payload = payload_buffer;
+
+    // Send the request and get the response
+    if (!co_await sendRequest(file_request)) {
+        co_return false;
+    }
+    Response file_response = co_await getResponse();
+    co_return file_response.code == ServerResponses::CONFIRM_MSG;
+}
+
+/**
+ * Handles a connection request with the server.
+ * @param clientId The client's identifier, received from the server.
+ * @param requestCode The request code (registration or reconnection).
+ * @return The response from the server.
+ */
+Task<Response> AsyncProtocolHandler::handleConnectionRequest(char* clientId, uint16_t requestCode) {
+    Request request {};
+    PayloadArena::Scope scope(payloadArena_);
+    char* payload_buffer = payloadArena_.allocate(ServerRequests::Consts::NAME_FIELD_SIZE);
+    std::memset(payload_buffer, 0, ServerRequests::Consts::NAME_FIELD_SIZE);
+    // Initializing a default "empty" clientId:
+    std::memset(request.clientId, 0, sizeof(request.clientId));
+    // Defining the request attributes:
+    request.version = PROTOCOL_VERSION;
+    request.code = requestCode;
+    std::strncpy(payload_buffer, clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
+    request.payloadSize = ServerRequests::Consts::NAME_FIELD_SIZE;
+    request.payload = payload_buffer;
+
+    // Performing a request:
+    if (!co_await sendRequest(request)) {
+        co_return Response{};
+    }
+    Response serverResponse = co_await getResponse();
+    // Store the received ClientId and return the response:
+    memcpy(clientId, serverResponse.payload.data(), std::min<size_t>(16, serverResponse.payload.size()));
+    co_return serverResponse;
+}
+
+/**
+ * Generates a key pair - X25519 if the server supports it, RSA otherwise - persists it, and sends its public key to
+ * the server. The key pair is generated on the offload pool.
+ * @param clientId The client's identifier.
+ * @param outPrivateKey The generated private key will be stored here.
+ * @param outKeyType The type of the generated private key will be stored here.
+ * @return The response from the server.
+ */
+Task<Response> AsyncProtocolHandler::handleKeyRegistration(char* clientId, std::string& outPrivateKey,
+                                                           KeyType& outKeyType) {
+    FileHandler fileHandler;
+    Request pubkey_request{};
+    memcpy(pubkey_request.clientId, clientId, 16);
+    std::pair<std::string, std::string> keyPair;
+    KeyType keyType = serverVersion_ >= X25519_KEY_EXCHANGE_PROTOCOL_VERSION ? KeyType::X25519 : KeyType::RSA;
+    if (keyType == KeyType::X25519) {
+        keyPair = co_await offload([]() { return CryptoHandler::generate_x25519_key_pair(); });
+        pubkey_request.version = X25519_KEY_EXCHANGE_PROTOCOL_VERSION;
+        pubkey_request.code = ServerRequests::Codes::SEND_X25519_PUBLIC_KEY;
+    } else {
+        // Take the next RSA pair generated in the background, without holding a thread while it is generated
+        keyPair = co_await takeRSAKeyPair();
+        pubkey_request.version = PROTOCOL_VERSION;
+        pubkey_request.code = ServerRequests::Codes::SEND_PUBLIC_KEY;
+    }
+    auto& [publicKey, privateKey] = keyPair;
+    outPrivateKey = privateKey;
+    outKeyType = keyType;
+
+    // The client name, followed by the public key (raw X25519 keys may contain zero bytes, so copy it as is)
+    PayloadArena::Scope scope(payloadArena_);
+    size_t totalPayloadSize = ServerRequests::Consts::NAME_FIELD_SIZE + publicKey.size();
+    char* payload_buffer = payloadArena_.allocate(totalPayloadSize);
+    std::memset(payload_buffer, 0, totalPayloadSize);
+    std::strncpy(payload_buffer, clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
+    std::memcpy(payload_buffer + ServerRequests::Consts::NAME_FIELD_SIZE, publicKey.data(), publicKey.size());
+    pubkey_request.payloadSize = totalPayloadSize;
+    pubkey_request.payload = payload_buffer;
+
+    // Save the private key + me.info:
+    fileHandler.savePrivateKey(privateKey, keyType);
+    fileHandler.saveMeInfo(clientName_, pubkey_request.clientId, privateKey, keyType);
+
+    // Performing a request, sending the public key to the server:
+    if (!co_await sendRequest(pubkey_request)) {
+        co_return Response{};
+    }
+    co_return co_await getResponse();
+}
+
+/**
+ * Decrypts the AES key sent by the server on the offload pool, using the client's private key - RSA or X25519, as its
+ * type tells. The RSA decryption context is only used from the offload pool, one flow at a time.
+ * @param encrypted_aes_key The AES key received from the server.
+ * @param keyType The type of the client's private key.
+ * @param privateKey The client's private key.
+ * @return The AES key.
+ */
+Task<std::string> AsyncProtocolHandler::decryptAesKey(const std::string& encrypted_aes_key, KeyType keyType,
+                                                      const std::string& privateKey) {
+    co_return co_await offload([this, &encrypted_aes_key, keyType, &privateKey]() {
+        return CryptoHandler::decrypt_aes_key(encrypted_aes_key, keyType, privateKey, rsaDecryptor_);
+    });
+}
+
+/**
+ * Handles the encryption and sending of a file to the server.
+ * @param encrypted_aes_key The AES key received from the server.
+ * @param keyType The type of the client's private key.
+ * @param privateKey The client's private key (RSA or X25519) for decryption.
+ * @param clientId The client's identifier.
+ * @return True if the file is successfully encrypted and sent, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::handleFileEncryptionAndSend(const std::string& encrypted_aes_key, KeyType keyType,
+                                                             const std::string& privateKey, const char* clientId) {
+    std::string aes_key = co_await decryptAesKey(encrypted_aes_key, keyType, privateKey);
+    co_return co_await sendFiles(aes_key, clientId);
+}
+
+/**
+ * Sends every file of the session over the current connection, each through its own SEND_FILE and CRC round. Stops
+ * once the connection is lost, leaving the remaining files unsent.
+ * @param aes_key The plain AES key shared with the server.
+ * @param clientId The client's identifier.
+ * @return True if all the files were successfully encrypted and sent, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::sendFiles(const std::string& aes_key, const char* clientId) {
+    size_t sent = 0;
+    for (const std::string& filePath : filePaths_) {
+        filePath_ = filePath;
+        logger_.info((std::ostringstream() << "Sending " << filePath_).str());
+        if (co_await sendEncryptedFile(aes_key, clientId)) {
+            sent++;
+        } else {
+            logger_.error((std::ostringstream() << "Failed sending " << filePath_).str());
+        }
+        if (connectionLost_) {
+            logger_.serverError("Lost the connection to the server, not sending the remaining files");
+            break;
+        }
+    }
+    logger_.info((std::ostringstream() << "Sent " << sent << " of " << filePaths_.size()
+                                       << " files over a single session").str());
+    co_return sent == filePaths_.size();
+}
+
+/**
+ * Encrypts the file on the offload pool (calculating its CRC in the same pass) and sends it to the server, repeating
+ * the upload up to 3 times while the CRC the server calculated doesn't match ours. Gives up at once if the connection
+ * is lost - there's no point in resending over it. Multi-part uploads stay with the blocking ProtocolHandler, so the
+ * content must fit a single request.
+ * @param aes_key The plain AES key shared with the server.
+ * @param clientId The client's identifier.
+ * @return True if the file was successfully sent and verified, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::sendEncryptedFile(const std::string& aes_key, const char* clientId) {
+    const int maxRetries = 3;
+
+    // Pick the richest content encoding the server advertised:
+    ContentEncoding encoding = ContentEncoding::HEX;
+    char requestVersion = PROTOCOL_VERSION;
+    if (serverVersion_ >= SEGMENTED_GCM_PROTOCOL_VERSION) {
+        encoding = ContentEncoding::SEGMENTED_GCM;
+        requestVersion = SEGMENTED_GCM_PROTOCOL_VERSION;
+    } else if (serverVersion_ >= BINARY_CONTENT_PROTOCOL_VERSION) {
+        encoding = ContentEncoding::BINARY;
+        requestVersion = BINARY_CONTENT_PROTOCOL_VERSION;
+    }
+
+    std::error_code error;
+    size_t fileSize = std::filesystem::file_size(filePath_, error);
+    if (error) {
+        logger_.error((std::ostringstream() << "Unable to open " << filePath_).str());
+        co_return false;
+    }
+    size_t contentSize = CryptoHandler::encrypted_content_size(fileSize, encoding);
+    if (contentSize > UINT32_MAX - 4 - 255) {
+        logger_.error("File is too large to be sent in a single request");
+        co_return false;
+    }
+
+    // content size (4 bytes, big-endian) | file name (255 bytes) | content
+    PayloadArena::Scope scope(payloadArena_);
+    char* payloadBuffer = payloadArena_.allocate(4 + 255 + contentSize);
+    std::memset(payloadBuffer, 0, 4 + 255);
+    uint32_t contentSizeNetworkOrder = htonl(static_cast<uint32_t>(contentSize));
+    std::memcpy(payloadBuffer, &contentSizeNetworkOrder, 4);
+    std::strncpy(payloadBuffer + 4, filePath_.c_str(), 255);
+
+    // Read the file once on the offload pool, encrypting it and calculating its CRC in the same pass
+    uint32_t fileCrc = 0;
+    size_t written = co_await offload([&]() -> size_t {
+        FileHandler fileHandler;
+        std::ifstream fileStream;
+        try {
+            fileStream = fileHandler.openFileForReading(filePath_);
+        } catch (const std::runtime_error& e) {
+            logger_.error(e.what());
+            return SIZE_MAX;
+        }
+        if (!sessionCipher_ || aes_key.size() != AESWrapper::DEFAULT_KEYLENGTH ||
+            std::memcmp(sessionCipher_->getKey(), aes_key.data(), AESWrapper::DEFAULT_KEYLENGTH) != 0) {
+            sessionCipher_ = CryptoHandler::create_aes_cipher(aes_key);
+        }
+        try {
+            char* content = payloadBuffer + 4 + 255;
+            if (encoding == ContentEncoding::SEGMENTED_GCM) {
+                return CryptoHandler::encrypt_stream_with_aes_gcm(fileStream, fileSize, *sessionCipher_, segmentPool_,
+                                                                  segmentBuffers_, content, contentSize, fileCrc);
+            }
+            return CryptoHandler::encrypt_stream_with_aes(fileStream, *sessionCipher_, encoding, content, contentSize,
+                                                          fileCrc);
+        } catch (const std::runtime_error& e) {
+            logger_.error((std::ostringstream() << "Failed encrypting file: " << e.what()).str());
+            return SIZE_MAX;
+        } catch (const std::length_error&) {
+            return SIZE_MAX;  // The file grew past the size the payload was allocated for
+        }
+    });
+    if (written != contentSize) {
+        logger_.error("File changed or could not be read while it was being encrypted");
+        co_return false;
+    }
+
+    Request encrypted_file_request{};
+    memcpy(encrypted_file_request.clientId, clientId, 16);
+    encrypted_file_request.version = requestVersion;
+    encrypted_file_request.code = ServerRequests::Codes::SEND_FILE;
+    encrypted_file_request.payloadSize = 4 + 255 + contentSize;
+    encrypted_file_request.payload = payloadBuffer;
+
+    for (int retry_count = 0; retry_count < maxRetries; ++retry_count) {
+        Response response{};
+        if (co_await sendRequest(encrypted_file_request)) {
+            response = co_await getResponse();
+        }
+        if (response.code == 0) {
+            logger_.serverError("upload was interrupted, giving up on the file");
+            co_return false;
+        }
+        if (response.code != ServerResponses::FILE_RECEIVED_CRC_OK) {
+            continue;
+        }
+        // Extract last 4 bytes that represent the CRC:
+        uint32_t receivedCRC = 0;
+        if (response.payload.size() >= 4) {
+            std::memcpy(&receivedCRC, response.payload.data() + response.payload.size() - 4, 4);
+        }
+        if (receivedCRC == fileCrc) {
+            logger_.info("CRC Match, Responding with CRC Correct status to server");
+            if (co_await sendCRCStatusRequest(clientId, ServerRequests::Codes::CRC_CORRECT)) {
+                logger_.info("Successfully finished Client's file sending flow");
+                co_return true;
+            }
+            logger_.serverError("Failed to finish Client's file sending flow - server didn't accept message.");
+            co_return false;
+        }
+        logger_.error("CRC not matching, Responding with CRC Incorrect status to server...");
+        co_await sendCRCStatusRequest(clientId, ServerRequests::Codes::CRC_INCORRECT_RESEND);
+    }
+
+    // If after max_retries we didn't get a successful response, send a failure request with CRC_INCORRECT_DONE code:
+    logger_.serverError("reached max retries but wasn't able to successfully upload file to server");
+    co_await sendCRCStatusRequest(clientId, ServerRequests::Codes::CRC_INCORRECT_DONE);
+    co_return false;
+}
+
+/**
+ * Handles the registration process with the server.
+ * @return True if registration is successful, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::handleRegistration() {
+    char clientId[16];
+    logger_.info((std::ostringstream() << "Starting registration flow for client " << clientName_ << "...").str());
+
+    // Step 1: Send registration request with an empty clientId + check if response is valid:
+    Response serverResponse = co_await handleConnectionRequest(clientId, ServerRequests::Codes::REGISTRATION);
+    if (serverResponse.code != ServerResponses::REGISTRATION_SUCCESS) {
+        logger_.serverError("Failed to register to the server");
+        co_return false;
+    }
+    logger_.info((std::ostringstream() << "successfully registered " << clientName_ << " to server").str());
+
+    // Step 2: Handle key registration
+    std::string privateKey;
+    KeyType keyType;
+    serverResponse = co_await handleKeyRegistration(clientId, privateKey, keyType);
+    // The payload is the client id (16 bytes) followed by the encrypted AES key
+    if (serverResponse.code != ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES || serverResponse.payload.size() <= 16) {
+        logger_.serverError("Received an invalid status from the server during key generation step");
+        co_return false;
+    }
+    logger_.info("Successfully generated key pair and received valid status and AES key from server");
+
+    // Step 3: Encrypt file using AES key and send to the server
+    std::string encrypted_aes_key(serverResponse.payload.substr(16));
+    co_return co_await handleFileEncryptionAndSend(encrypted_aes_key, keyType, privateKey, clientId);
+}
+
+/**
+ * Handles the reconnection process with the server. If the client doesn't exist yet, this method will fallback into
+ * registration. The AES key sent with the approval is decrypted using the stored private key, unless a key rotation
+ * was requested or the stored key can't be used - in which case a new key pair is registered.
+ * @param base64PrivateKey The private key persisted in me.info, in Base64.
+ * @param keyType The type of the private key persisted in me.info.
+ * @param rotateKey Whether to generate a new key pair and send its public key to the server.
+ * @return True if reconnection is successful, false otherwise.
+ */
+Task<bool> AsyncProtocolHandler::handleReconnection(const std::string& base64PrivateKey, KeyType keyType,
+                                                    bool rotateKey) {
+    char clientId[16];
+    logger_.info((std::ostringstream() << "Starting reconnection flow for client " << clientName_ << "...").str());
+
+    // Step 1: Send reconnection request + check if response is valid:
+    Response serverResponse = co_await handleConnectionRequest(clientId, ServerRequests::Codes::RECONNECT);
+    if (serverResponse.code == ServerResponses::RECONNECT_REJECTED) {
+        // Try and to perform a registration request.
+        co_return co_await handleRegistration();
+    } else if (serverResponse.code != ServerResponses::APPROVE_RECONNECT_SEND_AES) {
+        logger_.serverError((std::ostringstream() << "failed to reconnect to the server - " << serverResponse.payload).str());
+        co_return false;
+    }
+
+    // Step 2: Decrypt the AES key using the stored private key, falling back into key registration if needed
+    std::string aes_key;
+    if (!rotateKey && serverResponse.payload.size() > 16 && !base64PrivateKey.empty()) {
+        std::string encrypted_aes_key(serverResponse.payload.substr(16));
+        try {
+            std::string privateKey = Base64Wrapper::decode(base64PrivateKey);
+            aes_key = co_await decryptAesKey(encrypted_aes_key, keyType, privateKey);
+        } catch (const std::exception& e) {
+            logger_.warning((std::ostringstream() << "Failed decrypting AES key using the stored private key: " << e.what()).str());
+        }
+    }
+    if (aes_key.empty()) {
+        std::string privateKey;
+        KeyType newKeyType;
+        serverResponse = co_await handleKeyRegistration(clientId, privateKey, newKeyType);
+        if (serverResponse.code != ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES || serverResponse.payload.size() <= 16) {
+            logger_.serverError("Received an invalid status from the server during key generation step");
+            co_return false;
+        }
+        logger_.info("Successfully generated key pair and received valid status and AES key from server");
+        aes_key = co_await decryptAesKey(std::string(serverResponse.payload.substr(16)), newKeyType, privateKey);
+    }
+
+    // Step 3: Encrypt file using AES key and send to the server
+    co_return co_await sendFiles(aes_key, clientId);
+}
@@ -0,0 +1,140 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for AsyncProtocolHandler.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_ASYNCPROTOCOLHANDLER_H
+#define DEFENSIVE_MAMAN_15_ASYNCPROTOCOLHANDLER_H
+
+#include <coroutine>
+#include <exception>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "EventLoop.h"
+#include "ProtocolHandler.h"
+#include "PayloadArena.h"
+#include "CryptoHandler.h"
+#include "ThreadPool.h"
+#include "Logger.h"
+#include "Task.h"
+
+class AESWrapper;
+class RSAPrivateWrapper;
+struct iovec;
+
+// The coroutine counterpart of ProtocolHandler: the same registration, reconnection and upload flows, written as
+// the same linear code, but awaiting a non-blocking socket on an EventLoop instead of blocking on it. CPU heavy steps
+// (key generation, key decryption, encryption and CRC) are awaited on a thread pool, so the loop's thread only ever
+// runs the flows themselves - and can run many handlers side by side.
+class AsyncProtocolHandler : private EventHandler {
+public:
+    AsyncProtocolHandler(EventLoop& loop, ThreadPool& offloadPool, ThreadPool& segmentPool, std::string server_address,
+                         int port, std::string name, std::vector<std::string> filePaths);
+    ~AsyncProtocolHandler() override;
+
+    Task<bool> handleConnection();
+    Task<bool> handleRegistration();
+    Task<bool> handleReconnection(const std::string& base64PrivateKey, KeyType keyType, bool rotateKey = false);
+    Task<bool> handleFileEncryptionAndSend(const std::string& encrypted_aes_key, KeyType keyType,
+                                           const std::string& privateKey, const char* clientId);
+    Task<bool> sendRequest(const Request& request);
+    Task<Response> getResponse();
+
+private:
+    // Suspends the awaiting flow until the socket is ready for the given events
+    struct Readiness {
+        AsyncProtocolHandler& handler;
+        uint32_t events;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting);
+        void await_resume() const noexcept {}
+    };
+
+    // Runs work on the offload pool, resuming the awaiting flow on the loop's thread with its result
+    template <typename Work>
+    struct Offload {
+        using Result = decltype(std::declval<Work&>()());
+
+        AsyncProtocolHandler& handler;
+        Work work;
+        std::optional<Result> result;
+        std::exception_ptr error;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting) {
+            EventLoop& loop = handler.loop_;
+            loop.retain();
+            handler.offloadPool_.submit([this, awaiting, &loop]() {
+                try {
+                    result.emplace(work());
+                } catch (...) {
+                    error = std::current_exception();
+                }
+                loop.post([awaiting, &loop]() {
+                    loop.release();
+                    awaiting.resume();
+                });
+            });
+        }
+        Result await_resume() {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+            return std::move(*result);
+        }
+    };
+
+    template <typename Work>
+    Offload<Work> offload(Work work) {
+        return Offload<Work>{*this, std::move(work), std::nullopt, nullptr};
+    }
+
+    // Suspends the awaiting flow until the key factory hands it an RSA key pair, resuming it on the loop's thread -
+    // neither the loop's thread nor a pool thread waits for the pair to be generated
+    struct RSAKeyPairTake {
+        AsyncProtocolHandler& handler;
+        std::pair<std::string, std::string> keyPair;
+        std::exception_ptr error;
+
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<> awaiting);
+        std::pair<std::string, std::string> await_resume();
+    };
+
+    EventLoop& loop_;
+    ThreadPool& offloadPool_;
+    ThreadPool& segmentPool_;  // Kept apart from the offload pool, whose encryption step waits for the segments
+    std::string serverAddress_;
+    std::string clientName_;
+    std::vector<std::string> filePaths_;
+    std::string filePath_;  // The file currently being sent
+    int socket_ = -1;
+    bool connectionLost_ = false;  // Set once a request or a response was cut short
+    int port_;
+    char serverVersion_;
+    std::coroutine_handle<> waiting_;
+    std::unique_ptr<AESWrapper> sessionCipher_;
+    RSADecryptorCache rsaDecryptor_;
+    GcmSegmentBuffers segmentBuffers_;
+    std::vector<char> receiveBuffer_;
+    PayloadArena payloadArena_;
+    Logger logger_;
+
+    void onEvents(uint32_t events) override;
+    Readiness ready(uint32_t events);
+    RSAKeyPairTake takeRSAKeyPair();
+    Task<> sendParts(iovec* parts, size_t count);
+    Task<size_t> receiveExactly(char* buffer, size_t length);
+    Task<Response> handleConnectionRequest(char* clientId, uint16_t requestCode);
+    Task<Response> handleKeyRegistration(char* clientId, std::string& outPrivateKey, KeyType& outKeyType);
+    Task<std::string> decryptAesKey(const std::string& encrypted_aes_key, KeyType keyType, const std::string& privateKey);
+    Task<bool> sendFiles(const std::string& aes_key, const char* clientId);
+    Task<bool> sendEncryptedFile(const std::string& aes_key, const char* clientId);
+    Task<bool> sendCRCStatusRequest(const char* clientId, uint16_t code);
+};
+
+
+#endif
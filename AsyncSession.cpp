@@ -0,0 +1,571 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Drive a client session over a non-blocking socket, one request / response step at a time, so many
+ * sessions can share a single thread.
+ */
+#include "AsyncSession.h"
+#include "CryptoHandler.h"
+#include "AESWrapper.h"
+#include "RSAKeyFactory.h"
+#include "RSAWrapper.h"
+#include "ThreadPool.h"
+#include "constants.h"
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <utility>
+
+AsyncSession::AsyncSession(EventLoop& loop, ThreadPool& workerPool, ThreadPool& segmentPool, std::string serverAddress,
+                           int port, std::string name, std::string privateKey, KeyType keyType,
+                           ProtocolHandler::FileSource fileSource, const std::string& loggerName)
+        : loop_(loop), workerPool_(workerPool), segmentPool_(segmentPool), serverAddress_(std::move(serverAddress)),
+          port_(port), clientName_(std::move(name)), privateKey_(std::move(privateKey)), keyType_(keyType),
+          ownsIdentity_(privateKey_.empty()), fileSource_(std::move(fileSource)),
+          logger_(loggerName), serverVersion_(PROTOCOL_VERSION) {}
+
+AsyncSession::~AsyncSession() {
+    if (socket_ != -1) {
+        loop_.remove(socket_);
+        close(socket_);
+    }
+}
+
+/**
+ * Starts connecting to the server. The rest of the session is driven by the loop's events.
+ */
+void AsyncSession::start() {
+    socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (socket_ == -1) {
+        fail("failed to create a socket");
+        return;
+    }
+    sockaddr_in server_addr{};
+    server_addr.sin_family = AF_INET;
+    server_addr.sin_port = htons(port_);
+    inet_pton(AF_INET, serverAddress_.c_str(), &server_addr.sin_addr);
+    if (connect(socket_, (struct sockaddr *)&server_addr, sizeof(server_addr)) < 0 && errno != EINPROGRESS) {
+        fail("failed to connect to the server");
+        return;
+    }
+    // The socket turns writable once the connection is established (or has failed):
+    loop_.add(socket_, EPOLLOUT, this);
+}
+
+/**
+ * Handles the readiness events of the session's socket.
+ * @param events The events the socket is ready for.
+ */
+void AsyncSession::onEvents(uint32_t events) {
+    if (socket_ == -1) {
+        return;  // Events collected before the session was closed
+    }
+    try {
+        if (state_ == State::CONNECTING) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            getsockopt(socket_, SOL_SOCKET, SO_ERROR, &error, &length);
+            if (error != 0) {
+                fail("failed to connect to the server - " + std::string(std::strerror(error)));
+                return;
+            }
+            onConnected();
+        } else if (events & EPOLLOUT) {
+            onWritable();
+        } else if (events & (EPOLLIN | EPOLLERR | EPOLLHUP)) {
+            onReadable();
+        }
+    } catch (const std::exception& e) {
+        fail(e.what());
+    }
+}
+
+/**
+ * Gets whether the session finished, and sent every file it took.
+ * @return True if the session succeeded, false otherwise.
+ */
+bool AsyncSession::succeeded() const {
+    return state_ == State::DONE && filesSent_ == filesAttempted_;
+}
+
+/**
+ * Gets the number of files the session sent and had verified.
+ * @return The number of files sent.
+ */
+size_t AsyncSession::filesSent() const {
+    return filesSent_;
+}
+
+/**
+ * Starts the session's first flow once connected - reconnection if a private key is known, registration otherwise.
+ */
+void AsyncSession::onConnected() {
+    if (privateKey_.empty()) {
+        state_ = State::REGISTERING;
+        sendNamePayload(ServerRequests::Codes::REGISTRATION);
+    } else {
+        state_ = State::RECONNECTING;
+        sendNamePayload(ServerRequests::Codes::RECONNECT);
+    }
+}
+
+/**
+ * Allocates the payload of a request other than SEND_FILE, releasing the previous such request's payload.
+ * @param size The payload's size.
+ * @return The uninitialized payload, valid until the next request payload is allocated.
+ */
+char* AsyncSession::allocateRequestPayload(size_t size) {
+    requestScope_.reset();
+    requestScope_.emplace(payloadArena_);
+    return payloadArena_.allocate(size);
+}
+
+/**
+ * Starts sending a request, writing as much of it as the socket accepts right away.
+ * @param code The request code.
+ * @param version The request version.
+ * @param payload The request payload, which must stay valid until the response arrives.
+ * @param payloadSize The payload's size.
+ */
+void AsyncSession::sendRequest(uint16_t code, char version, const char* payload, size_t payloadSize) {
+    using namespace WireFormat;
+    RequestHeader::ClientId::store(requestHeader_, clientId_);
+    RequestHeader::Version::store(requestHeader_, static_cast<uint8_t>(version));
+    RequestHeader::Code::store(requestHeader_, code);
+    RequestHeader::PayloadSize::store(requestHeader_, static_cast<uint32_t>(payloadSize));
+    requestPayload_ = payload;
+    requestPayloadSize_ = payloadSize;
+    requestSent_ = 0;
+    onWritable();
+}
+
+/**
+ * Writes the rest of the current request, waiting for the socket to turn writable whenever it is full, and for the
+ * response once the request was sent in full.
+ * @throws std::system_error If the socket fails.
+ */
+void AsyncSession::onWritable() {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;  // Report a closed connection as EPIPE instead of raising SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    size_t total = sizeof(requestHeader_) + requestPayloadSize_;
+    while (requestSent_ < total) {
+        iovec parts[2];
+        size_t count = 0;
+        if (requestSent_ < sizeof(requestHeader_)) {
+            parts[count++] = {requestHeader_ + requestSent_, sizeof(requestHeader_) - requestSent_};
+        }
+        size_t payloadSent = requestSent_ > sizeof(requestHeader_) ? requestSent_ - sizeof(requestHeader_) : 0;
+        if (payloadSent < requestPayloadSize_) {
+            parts[count++] = {const_cast<char*>(requestPayload_) + payloadSent, requestPayloadSize_ - payloadSent};
+        }
+        msghdr message{};
+        message.msg_iov = parts;
+        message.msg_iovlen = count;
+        ssize_t sent = sendmsg(socket_, &message, flags);
+        if (sent == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                loop_.modify(socket_, EPOLLOUT, this);
+                return;
+            }
+            throw std::system_error(errno, std::system_category(), "Failed to send message to server");
+        }
+        requestSent_ += static_cast<size_t>(sent);
+    }
+    responseReceived_ = 0;
+    loop_.modify(socket_, EPOLLIN, this);
+}
+
+/**
+ * Receives as much of the current response as has arrived, handling it once it arrived in full.
+ * @throws std::system_error If the socket fails.
+ */
+void AsyncSession::onReadable() {
+    using namespace WireFormat;
+    while (true) {
+        size_t expected = ResponseHeader::SIZE;
+        if (responseReceived_ >= ResponseHeader::SIZE) {
+            expected += ResponseHeader::PayloadSize::load(responseBuffer_.data());
+            if (responseReceived_ == expected) {
+                break;
+            }
+        }
+        if (responseBuffer_.size() < expected) {
+            responseBuffer_.resize(expected);
+        }
+        ssize_t received = recv(socket_, responseBuffer_.data() + responseReceived_, expected - responseReceived_, 0);
+        if (received == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            if (errno == EAGAIN || errno == EWOULDBLOCK) {
+                return;  // The rest of the response hasn't arrived yet
+            }
+            throw std::system_error(errno, std::system_category(), "recv failed");
+        }
+        if (received == 0) {
+            fail("server closed the connection");
+            return;
+        }
+        responseReceived_ += static_cast<size_t>(received);
+    }
+
+    Response response{};
+    response.version = char(ResponseHeader::Version::load(responseBuffer_.data()) + '0');  // Convert to ascii value.
+    serverVersion_ = response.version;
+    response.code = ResponseHeader::Code::load(responseBuffer_.data());
+    response.payloadSize = ResponseHeader::PayloadSize::load(responseBuffer_.data());
+    response.payload = std::string_view(responseBuffer_.data() + ResponseHeader::SIZE, response.payloadSize);
+    onResponse(response);
+}
+
+/**
+ * Advances the session's state machine according to the response to the request its current state has sent.
+ * @param response The response received from the server.
+ */
+void AsyncSession::onResponse(const Response& response) {
+    switch (state_) {
+        case State::RECONNECTING:
+            std::memcpy(clientId_, response.payload.data(), std::min<size_t>(16, response.payload.size()));
+            if (response.code == ServerResponses::RECONNECT_REJECTED) {
+                if (!ownsIdentity_) {
+                    fail("server rejected the reconnection of the stored client");
+                    return;
+                }
+                // Try and to perform a registration request.
+                state_ = State::REGISTERING;
+                sendNamePayload(ServerRequests::Codes::REGISTRATION);
+            } else if (response.code != ServerResponses::APPROVE_RECONNECT_SEND_AES) {
+                fail("failed to reconnect to the server");
+            } else if (!acceptAesKey(response.payload)) {
+                if (!ownsIdentity_) {
+                    fail("Failed decrypting AES key using the stored private key");
+                    return;
+                }
+                logger_.warning("Failed decrypting AES key using the stored private key");
+                sendPublicKey();
+            } else {
+                sendNextFile();
+            }
+            break;
+
+        case State::REGISTERING:
+            if (response.code != ServerResponses::REGISTRATION_SUCCESS) {
+                fail("Failed to register to the server");
+                return;
+            }
+            std::memcpy(clientId_, response.payload.data(), std::min<size_t>(16, response.payload.size()));
+            sendPublicKey();
+            break;
+
+        case State::SENDING_PUBLIC_KEY:
+            if (response.code != ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES) {
+                fail("Received an invalid status from the server during key generation step");
+            } else if (!acceptAesKey(response.payload)) {
+                fail("Failed decrypting the AES key sent by the server");
+            } else {
+                sendNextFile();
+            }
+            break;
+
+        case State::SENDING_FILE:
+            if (response.code == ServerResponses::FILE_RECEIVED_CRC_OK) {
+                // Extract last 4 bytes that represent the CRC:
+                uint32_t receivedCRC = 0;
+                if (response.payload.size() >= 4) {
+                    std::memcpy(&receivedCRC, response.payload.data() + response.payload.size() - 4, 4);
+                }
+                if (receivedCRC == fileCrc_) {
+                    sendCrcStatus(ServerRequests::Codes::CRC_CORRECT);
+                    return;
+                }
+                logger_.error("CRC not matching, Responding with CRC Incorrect status to server...");
+            }
+            if (++attempts_ < MAX_RETRIES) {
+                sendCrcStatus(ServerRequests::Codes::CRC_INCORRECT_RESEND);
+            } else {
+                logger_.serverError("reached max retries but wasn't able to successfully upload file to server");
+                sendCrcStatus(ServerRequests::Codes::CRC_INCORRECT_DONE);
+            }
+            break;
+
+        case State::SENDING_CRC_STATUS:
+            if (crcStatus_ == ServerRequests::Codes::CRC_INCORRECT_RESEND) {
+                resendFile();
+                return;
+            }
+            if (crcStatus_ == ServerRequests::Codes::CRC_CORRECT && response.code == ServerResponses::CONFIRM_MSG) {
+                logger_.info((std::ostringstream() << "Successfully sent " << filePath_).str());
+                filesSent_++;
+            } else {
+                logger_.error((std::ostringstream() << "Failed sending " << filePath_).str());
+            }
+            sendNextFile();
+            break;
+
+        default:
+            break;
+    }
+}
+
+/**
+ * Sends a request whose payload is the client's name - registration and reconnection.
+ * @param code The request code.
+ */
+void AsyncSession::sendNamePayload(uint16_t code) {
+    char* payload = allocateRequestPayload(ServerRequests::Consts::NAME_FIELD_SIZE);
+    std::memset(payload, 0, ServerRequests::Consts::NAME_FIELD_SIZE);
+    std::strncpy(payload, clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
+    sendRequest(code, PROTOCOL_VERSION, payload, ServerRequests::Consts::NAME_FIELD_SIZE);
+}
+
+/**
+ * Generates a key pair - X25519 if the server supports it, RSA otherwise - and sends its public key to the server.
+ * RSA key pairs are taken from the key factory without waiting for one to be generated, and the public key is sent
+ * once the factory hands the pair back to the loop - the loop keeps driving the other sessions meanwhile.
+ */
+void AsyncSession::sendPublicKey() {
+    if (serverVersion_ >= X25519_KEY_EXCHANGE_PROTOCOL_VERSION) {
+        sendPublicKey(CryptoHandler::generate_x25519_key_pair(), KeyType::X25519,
+                      ServerRequests::Codes::SEND_X25519_PUBLIC_KEY, X25519_KEY_EXCHANGE_PROTOCOL_VERSION);
+        return;
+    }
+    // No response is expected until the key is sent, so only a closed connection is watched for meanwhile
+    state_ = State::GENERATING_KEY;
+    responseReceived_ = 0;
+    loop_.modify(socket_, 0, this);
+    loop_.retain();
+    RSAKeyFactory::shared().take([this](std::pair<std::string, std::string> keyPair, std::exception_ptr error) {
+        loop_.post([this, keyPair = std::move(keyPair), error]() mutable {
+            loop_.release();
+            if (socket_ == -1) {
+                return;  // The session ended while the key was being generated
+            }
+            try {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+                sendPublicKey(std::move(keyPair), KeyType::RSA, ServerRequests::Codes::SEND_PUBLIC_KEY, PROTOCOL_VERSION);
+            } catch (const std::exception& e) {
+                fail((std::ostringstream() << "Failed sending an RSA public key: " << e.what()).str());
+            }
+        });
+    });
+}
+
+/**
+ * Sends the public key of a key pair to the server, keeping its private key. The private key is only kept in memory:
+ * sessions driven by the loop stand for many clients, none of which owns me.info.
+ * @param keyPair The public and private keys.
+ * @param keyType The type of the keys.
+ * @param code The request code matching the key's type.
+ * @param version The request version matching the key's type.
+ */
+void AsyncSession::sendPublicKey(std::pair<std::string, std::string> keyPair, KeyType keyType, uint16_t code,
+                                 char version) {
+    privateKey_ = std::move(keyPair.second);
+    keyType_ = keyType;
+
+    size_t payloadSize = ServerRequests::Consts::NAME_FIELD_SIZE + keyPair.first.size();
+    char* payload = allocateRequestPayload(payloadSize);
+    std::memset(payload, 0, ServerRequests::Consts::NAME_FIELD_SIZE);
+    std::strncpy(payload, clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
+    std::memcpy(payload + ServerRequests::Consts::NAME_FIELD_SIZE, keyPair.first.data(), keyPair.first.size());
+    state_ = State::SENDING_PUBLIC_KEY;
+    sendRequest(code, version, payload, payloadSize);
+}
+
+/**
+ * Decrypts the AES key sent by the server (following the client id) and sets the session's cipher up with it.
+ * @param payload The payload of the response carrying the AES key.
+ * @return True if the key was decrypted, false otherwise.
+ */
+bool AsyncSession::acceptAesKey(std::string_view payload) {
+    if (payload.size() <= 16 || privateKey_.empty()) {
+        return false;
+    }
+    std::string encrypted_aes_key(payload.substr(16));
+    try {
+        std::string aes_key = CryptoHandler::decrypt_aes_key(encrypted_aes_key, keyType_, privateKey_, rsaDecryptor_);
+        cipher_ = CryptoHandler::create_aes_cipher(aes_key);
+    } catch (const std::exception& e) {
+        logger_.warning((std::ostringstream() << "Failed decrypting AES key: " << e.what()).str());
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Takes files from the session's source until one of them is being sent, finishing the session once there are none
+ * left.
+ */
+void AsyncSession::sendNextFile() {
+    while (fileSource_(filePath_)) {
+        filesAttempted_++;
+        attempts_ = 0;
+        if (sendFile()) {
+            return;
+        }
+        logger_.error((std::ostringstream() << "Failed sending " << filePath_).str());
+    }
+    logger_.info((std::ostringstream() << "Sent " << filesSent_ << " of " << filesAttempted_
+                                       << " files over a single session").str());
+    finish(State::DONE);
+}
+
+/**
+ * Starts encrypting the current file into a SEND_FILE request on the worker pool, picking the richest content encoding
+ * the server advertised - the request is sent once the worker hands the payload back to the loop. Multi-part uploads
+ * aren't driven by the loop, so the content must fit a single request.
+ * @return True if the file is being encrypted, false if it couldn't be examined or is too large.
+ */
+bool AsyncSession::sendFile() {
+    ContentEncoding encoding = ContentEncoding::HEX;
+    fileRequestVersion_ = PROTOCOL_VERSION;
+    if (serverVersion_ >= SEGMENTED_GCM_PROTOCOL_VERSION) {
+        encoding = ContentEncoding::SEGMENTED_GCM;
+        fileRequestVersion_ = SEGMENTED_GCM_PROTOCOL_VERSION;
+    } else if (serverVersion_ >= BINARY_CONTENT_PROTOCOL_VERSION) {
+        encoding = ContentEncoding::BINARY;
+        fileRequestVersion_ = BINARY_CONTENT_PROTOCOL_VERSION;
+    }
+
+    std::error_code error;
+    size_t fileSize = std::filesystem::file_size(filePath_, error);
+    if (error) {
+        logger_.error((std::ostringstream() << "Unable to open " << filePath_).str());
+        return false;
+    }
+    size_t contentSize = CryptoHandler::encrypted_content_size(fileSize, encoding);
+    if (contentSize > UINT32_MAX - 4 - 255) {
+        logger_.error("File is too large to be sent in a single request");
+        return false;
+    }
+
+    // content size (4 bytes, big-endian) | file name (255 bytes) | content - kept until the next file is taken
+    requestScope_.reset();
+    fileScope_.reset();
+    fileScope_.emplace(payloadArena_);
+    char* payload = payloadArena_.allocate(4 + 255 + contentSize);
+    std::memset(payload, 0, 4 + 255);
+    uint32_t contentSizeNetworkOrder = htonl(static_cast<uint32_t>(contentSize));
+    std::memcpy(payload, &contentSizeNetworkOrder, 4);
+    std::strncpy(payload + 4, filePath_.c_str(), 255);
+    filePayload_ = payload;
+    filePayloadSize_ = 4 + 255 + contentSize;
+
+    // No response is expected until the file is sent, so only a closed connection is watched for meanwhile. The
+    // worker has the file, the cipher and the segment buffers to itself until it posts its result back.
+    state_ = State::ENCRYPTING_FILE;
+    responseReceived_ = 0;
+    loop_.modify(socket_, 0, this);
+    loop_.retain();
+    char* content = payload + 4 + 255;
+    workerPool_.submit([this, encoding, fileSize, content, contentSize]() {
+        size_t written = SIZE_MAX;
+        uint32_t crc = 0;
+        std::string failure;
+        try {
+            std::ifstream fileStream(filePath_, std::ios::in | std::ios::binary);
+            if (!fileStream) {
+                throw std::runtime_error("Unable to open " + filePath_);
+            }
+            if (encoding == ContentEncoding::SEGMENTED_GCM) {
+                written = CryptoHandler::encrypt_stream_with_aes_gcm(fileStream, fileSize, *cipher_, segmentPool_,
+                                                                     segmentBuffers_, content, contentSize, crc);
+            } else {
+                written = CryptoHandler::encrypt_stream_with_aes(fileStream, *cipher_, encoding, content, contentSize,
+                                                                 crc);
+            }
+        } catch (const std::exception& e) {
+            failure = e.what();
+        }
+        loop_.post([this, written, crc, failure = std::move(failure)]() {
+            loop_.release();
+            try {
+                onFileEncrypted(written, crc, failure);
+            } catch (const std::exception& e) {
+                fail(e.what());
+            }
+        });
+    });
+    return true;
+}
+
+/**
+ * Sends the current file once the worker encrypted it, or moves on to the next file if it couldn't.
+ * @param written The number of content bytes the worker wrote.
+ * @param crc The CRC of the file's plaintext.
+ * @param error What the encryption failed with, empty if it didn't throw.
+ */
+void AsyncSession::onFileEncrypted(size_t written, uint32_t crc, const std::string& error) {
+    if (socket_ == -1) {
+        return;  // The session ended while the file was being encrypted
+    }
+    if (!error.empty()) {
+        logger_.error((std::ostringstream() << "Failed encrypting file: " << error).str());
+    } else if (written != filePayloadSize_ - 4 - 255) {
+        logger_.error("File changed or could not be read while it was being encrypted");
+    } else {
+        fileCrc_ = crc;
+        resendFile();
+        return;
+    }
+    logger_.error((std::ostringstream() << "Failed sending " << filePath_).str());
+    sendNextFile();
+}
+
+/**
+ * Sends the current file's SEND_FILE request - the payload encrypted for its first attempt is sent again as is, so a
+ * CRC mismatch costs neither a read nor an encryption.
+ */
+void AsyncSession::resendFile() {
+    state_ = State::SENDING_FILE;
+    sendRequest(ServerRequests::Codes::SEND_FILE, fileRequestVersion_, filePayload_, filePayloadSize_);
+}
+
+/**
+ * Sends a CRC status request for the current file.
+ * @param code The CRC status request code.
+ */
+void AsyncSession::sendCrcStatus(uint16_t code) {
+    char* payload = allocateRequestPayload(filePath_.size() + 1);
+    std::memcpy(payload, filePath_.c_str(), filePath_.size() + 1);
+    crcStatus_ = code;
+    state_ = State::SENDING_CRC_STATUS;
+    sendRequest(code, PROTOCOL_VERSION, payload, filePath_.size() + 1);
+}
+
+/**
+ * Ends the session, closing its connection.
+ * @param state The state the session ended in.
+ */
+void AsyncSession::finish(State state) {
+    state_ = state;
+    if (socket_ != -1) {
+        loop_.remove(socket_);
+        close(socket_);
+        socket_ = -1;
+    }
+}
+
+/**
+ * Ends the session after an error.
+ * @param message A description of the error.
+ */
+void AsyncSession::fail(const std::string& message) {
+    logger_.serverError(message);
+    finish(State::FAILED);
+}
@@ -0,0 +1,122 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for AsyncSession.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_ASYNCSESSION_H
+#define DEFENSIVE_MAMAN_15_ASYNCSESSION_H
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+#include "EventLoop.h"
+#include "ProtocolHandler.h"
+#include "PayloadArena.h"
+#include "CryptoHandler.h"
+#include "WireFormat.h"
+#include "Logger.h"
+
+class AESWrapper;
+class RSAPrivateWrapper;
+class ThreadPool;
+
+// A client session driven by an EventLoop over a non-blocking socket - the registration, reconnection and upload
+// flows of ProtocolHandler, written as a state machine over the same requests. Each state sends one request and
+// waits for its response, so a single thread can drive as many sessions as it has descriptors for. Files are read
+// and encrypted on the worker pool, their segments on the segment pool, so the loop's thread only drives the sockets.
+class AsyncSession : public EventHandler {
+public:
+    AsyncSession(EventLoop& loop, ThreadPool& workerPool, ThreadPool& segmentPool, std::string serverAddress, int port,
+                 std::string name, std::string privateKey, KeyType keyType, ProtocolHandler::FileSource fileSource,
+                 const std::string& loggerName);
+    ~AsyncSession() override;
+
+    void start();
+    void onEvents(uint32_t events) override;
+    bool succeeded() const;
+    size_t filesSent() const;
+
+private:
+    enum class State {
+        CONNECTING,
+        RECONNECTING,
+        REGISTERING,
+        GENERATING_KEY,
+        SENDING_PUBLIC_KEY,
+        ENCRYPTING_FILE,
+        SENDING_FILE,
+        SENDING_CRC_STATUS,
+        DONE,
+        FAILED
+    };
+
+    static const int MAX_RETRIES = 3;
+
+    EventLoop& loop_;
+    ThreadPool& workerPool_;
+    ThreadPool& segmentPool_;  // Kept apart from the worker pool, whose encryption step waits for the segments
+    std::string serverAddress_;
+    int port_;
+    std::string clientName_;
+    std::string privateKey_;  // Registers the client with a new key pair when empty
+    KeyType keyType_;
+    // Whether the session registered its client itself - only then may it register it again or replace its key. A
+    // session started with the stored client's key shares that client with the other sessions and with me.info.
+    bool ownsIdentity_;
+    ProtocolHandler::FileSource fileSource_;
+    Logger logger_;
+    int socket_ = -1;
+    State state_ = State::CONNECTING;
+    char clientId_[16] = {};
+    char serverVersion_;
+    std::unique_ptr<AESWrapper> cipher_;
+    RSADecryptorCache rsaDecryptor_;
+    GcmSegmentBuffers segmentBuffers_;
+
+    // The file being sent
+    std::string filePath_;
+    const char* filePayload_ = nullptr;  // The encrypted SEND_FILE payload, kept for resends
+    size_t filePayloadSize_ = 0;
+    char fileRequestVersion_{};
+    uint32_t fileCrc_ = 0;
+    int attempts_ = 0;
+    uint16_t crcStatus_ = 0;
+    size_t filesAttempted_ = 0;
+    size_t filesSent_ = 0;
+
+    // Request payloads - the current file's payload lives in the file scope, every other request's in a request scope
+    // (nested in the file scope while a file is sent) that ends when the next request is made
+    PayloadArena payloadArena_;
+    std::optional<PayloadArena::Scope> fileScope_;
+    std::optional<PayloadArena::Scope> requestScope_;
+
+    // The request being sent, and the response being received
+    char requestHeader_[WireFormat::RequestHeader::SIZE] = {};
+    const char* requestPayload_ = nullptr;
+    size_t requestPayloadSize_ = 0;
+    size_t requestSent_ = 0;
+    std::vector<char> responseBuffer_;
+    size_t responseReceived_ = 0;
+
+    void onConnected();
+    char* allocateRequestPayload(size_t size);
+    void sendRequest(uint16_t code, char version, const char* payload, size_t payloadSize);
+    void onWritable();
+    void onReadable();
+    void onResponse(const Response& response);
+    void sendNamePayload(uint16_t code);
+    void sendPublicKey();
+    void sendPublicKey(std::pair<std::string, std::string> keyPair, KeyType keyType, uint16_t code, char version);
+    bool acceptAesKey(std::string_view payload);
+    void sendNextFile();
+    bool sendFile();
+    void onFileEncrypted(size_t written, uint32_t crc, const std::string& error);
+    void resendFile();
+    void sendCrcStatus(uint16_t code);
+    void finish(State state);
+    void fail(const std::string& message);
+};
+
+
+#endif
@@ -3,26 +3,306 @@
 //
 
 #include "Base64Wrapper.h"
+#include <stdexcept>
 
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BASE64_HAVE_SIMD 1
+#include <immintrin.h>
+#endif
 
-std::string Base64Wrapper::encode(const std::string &str) {
-    std::string encoded;
-    CryptoPP::StringSource ss(str, true,
-                              new CryptoPP::Base64Encoder(
-                                      new CryptoPP::StringSink(encoded)
-                              ) // Base64Encoder
-    ); // StringSource
+namespace
+{
+    const char ALPHABET[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    // Maps a character to its 6 bit value, or to one of the markers below
+    const unsigned char INVALID = 0xff;
+    const unsigned char WHITESPACE = 0xfe;
+    const unsigned char PADDING = 0xfd;
+
+    struct DecodeTable
+    {
+        unsigned char values[256];
+
+        DecodeTable()
+        {
+            for (unsigned char& value : values)
+                value = INVALID;
+            for (unsigned char i = 0; i < 64; ++i)
+                values[static_cast<unsigned char>(ALPHABET[i])] = i;
+            values[static_cast<unsigned char>(' ')] = WHITESPACE;
+            values[static_cast<unsigned char>('\t')] = WHITESPACE;
+            values[static_cast<unsigned char>('\r')] = WHITESPACE;
+            values[static_cast<unsigned char>('\n')] = WHITESPACE;
+            values[static_cast<unsigned char>('=')] = PADDING;
+        }
+    };
+
+    const DecodeTable DECODE_TABLE;
+
+    void encodeScalar(const unsigned char* in, size_t length, char* out)
+    {
+        for (; length >= 3; in += 3, out += 4, length -= 3)
+        {
+            out[0] = ALPHABET[in[0] >> 2];
+            out[1] = ALPHABET[((in[0] & 0x03) << 4) | (in[1] >> 4)];
+            out[2] = ALPHABET[((in[1] & 0x0f) << 2) | (in[2] >> 6)];
+            out[3] = ALPHABET[in[2] & 0x3f];
+        }
+        if (length > 0)
+        {
+            unsigned int second = length > 1 ? in[1] : 0;
+            out[0] = ALPHABET[in[0] >> 2];
+            out[1] = ALPHABET[((in[0] & 0x03) << 4) | (second >> 4)];
+            out[2] = length > 1 ? ALPHABET[(second & 0x0f) << 2] : '=';
+            out[3] = '=';
+        }
+    }
+
+    // Decodes one character at a time, skipping whitespace (e.g. a trailing '\r' read from a file)
+    size_t decodeScalar(const unsigned char* in, size_t length, unsigned char* out)
+    {
+        unsigned char* start = out;
+        unsigned int quantum = 0;
+        unsigned int count = 0;
+        size_t padding = 0;
+        for (size_t i = 0; i < length; ++i)
+        {
+            unsigned char value = DECODE_TABLE.values[in[i]];
+            if (value == WHITESPACE)
+                continue;
+            if (value == INVALID || (padding > 0 && value != PADDING))
+                throw std::invalid_argument("invalid Base64 character");
+            if (value == PADDING)
+            {
+                if (count < 2 || ++padding + count > 4)
+                    throw std::invalid_argument("invalid Base64 padding");
+                continue;
+            }
+            quantum = (quantum << 6) | value;
+            if (++count == 4)
+            {
+                out[0] = static_cast<unsigned char>(quantum >> 16);
+                out[1] = static_cast<unsigned char>(quantum >> 8);
+                out[2] = static_cast<unsigned char>(quantum);
+                out += 3;
+                quantum = 0;
+                count = 0;
+            }
+        }
+        if (count == 1 || (padding > 0 && padding + count != 4))
+            throw std::invalid_argument("truncated Base64 input");
+        if (count >= 2)
+        {
+            quantum <<= 6 * (4 - count);
+            *out++ = static_cast<unsigned char>(quantum >> 16);
+            if (count == 3)
+                *out++ = static_cast<unsigned char>(quantum >> 8);
+        }
+        return out - start;
+    }
+
+#ifdef BASE64_HAVE_SIMD
+    // The vector code follows Wojciech Muła's and Daniel Lemire's SSE Base64 algorithms: bytes are spread into 6 bit
+    // fields with multiplies, and mapped to / from ASCII by adding per range offsets looked up with PSHUFB.
+
+    __attribute__((target("ssse3")))
+    __m128i encodeSplit128(__m128i in)
+    {
+        in = _mm_shuffle_epi8(in, _mm_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10));
+        __m128i high = _mm_mulhi_epu16(_mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00)), _mm_set1_epi32(0x04000040));
+        __m128i low = _mm_mullo_epi16(_mm_and_si128(in, _mm_set1_epi32(0x003f03f0)), _mm_set1_epi32(0x01000010));
+        return _mm_or_si128(high, low);
+    }
+
+    __attribute__((target("ssse3")))
+    __m128i encodeTranslate128(__m128i indices)
+    {
+        const __m128i offsets = _mm_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                              '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        __m128i range = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+        range = _mm_or_si128(range, _mm_and_si128(_mm_cmpgt_epi8(_mm_set1_epi8(26), indices), _mm_set1_epi8(13)));
+        return _mm_add_epi8(indices, _mm_shuffle_epi8(offsets, range));
+    }
+
+    __attribute__((target("ssse3")))
+    void encodeSsse3(const unsigned char* in, size_t length, char* out)
+    {
+        // Each step reads 16 bytes but consumes 12 of them
+        for (; length >= 16; in += 12, out += 16, length -= 12)
+        {
+            __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), encodeTranslate128(encodeSplit128(bytes)));
+        }
+        encodeScalar(in, length, out);
+    }
+
+    __attribute__((target("avx2")))
+    void encodeAvx2(const unsigned char* in, size_t length, char* out)
+    {
+        const __m256i spread = _mm256_setr_epi8(1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10,
+                                                1, 0, 2, 1, 4, 3, 5, 4, 7, 6, 8, 7, 10, 9, 11, 10);
+        const __m256i offsets = _mm256_setr_epi8('a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0,
+                                                 'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+                                                 '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62, '/' - 63, 'A', 0, 0);
+        // Each step consumes 24 bytes (12 per lane) and reads up to in + 28
+        for (; length >= 28; in += 24, out += 32, length -= 24)
+        {
+            __m256i bytes = _mm256_inserti128_si256(
+                    _mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in))),
+                    _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + 12)), 1);
+            bytes = _mm256_shuffle_epi8(bytes, spread);
+            __m256i high = _mm256_mulhi_epu16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x0fc0fc00)),
+                                              _mm256_set1_epi32(0x04000040));
+            __m256i low = _mm256_mullo_epi16(_mm256_and_si256(bytes, _mm256_set1_epi32(0x003f03f0)),
+                                             _mm256_set1_epi32(0x01000010));
+            __m256i indices = _mm256_or_si256(high, low);
+            __m256i range = _mm256_subs_epu8(indices, _mm256_set1_epi8(51));
+            range = _mm256_or_si256(range, _mm256_and_si256(_mm256_cmpgt_epi8(_mm256_set1_epi8(26), indices),
+                                                            _mm256_set1_epi8(13)));
+            __m256i chars = _mm256_add_epi8(indices, _mm256_shuffle_epi8(offsets, range));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), chars);
+        }
+        encodeSsse3(in, length, out);
+    }
+
+    // Validates 16 characters and maps them to their 6 bit values; false if any of them isn't in the alphabet
+    __attribute__((target("ssse3")))
+    bool decodeTranslate128(__m128i chars, __m128i& values)
+    {
+        const __m128i lowNibble = _mm_set1_epi8(0x0f);
+        const __m128i validLow = _mm_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                               0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m128i validHigh = _mm_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m128i offsets = _mm_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        __m128i high = _mm_and_si128(_mm_srli_epi32(chars, 4), lowNibble);
+        __m128i invalid = _mm_and_si128(_mm_shuffle_epi8(validLow, _mm_and_si128(chars, lowNibble)),
+                                        _mm_shuffle_epi8(validHigh, high));
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(invalid, _mm_setzero_si128())) != 0xffff)
+            return false;
+        __m128i slash = _mm_cmpeq_epi8(chars, _mm_set1_epi8('/'));
+        values = _mm_add_epi8(chars, _mm_shuffle_epi8(offsets, _mm_add_epi8(slash, high)));
+        return true;
+    }
+
+    __attribute__((target("ssse3")))
+    __m128i decodePack128(__m128i values)
+    {
+        __m128i pairs = _mm_maddubs_epi16(values, _mm_set1_epi32(0x01400140));
+        __m128i triples = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00011000));
+        return _mm_shuffle_epi8(triples, _mm_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1));
+    }
+
+    __attribute__((target("ssse3")))
+    size_t decodeSsse3(const unsigned char* in, size_t length, unsigned char* out)
+    {
+        unsigned char* start = out;
+        // Each step stores 16 bytes but produces 12 of them - the 24 characters left guarantee the extra 4 bytes are
+        // still inside a buffer of maxDecodedLength. Blocks holding padding or whitespace are left to the scalar code.
+        for (; length >= 24; in += 16, out += 12, length -= 16)
+        {
+            __m128i values;
+            if (!decodeTranslate128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in)), values))
+                break;
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(out), decodePack128(values));
+        }
+        return (out - start) + decodeScalar(in, length, out);
+    }
+
+    __attribute__((target("avx2")))
+    size_t decodeAvx2(const unsigned char* in, size_t length, unsigned char* out)
+    {
+        const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+        const __m256i validLow = _mm256_setr_epi8(0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                  0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a,
+                                                  0x15, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x11,
+                                                  0x11, 0x11, 0x13, 0x1a, 0x1b, 0x1b, 0x1b, 0x1a);
+        const __m256i validHigh = _mm256_setr_epi8(0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                   0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10,
+                                                   0x10, 0x10, 0x01, 0x02, 0x04, 0x08, 0x04, 0x08,
+                                                   0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10);
+        const __m256i offsets = _mm256_setr_epi8(0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0,
+                                                 0, 16, 19, 4, -65, -65, -71, -71, 0, 0, 0, 0, 0, 0, 0, 0);
+        const __m256i pack = _mm256_setr_epi8(2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1,
+                                              2, 1, 0, 6, 5, 4, 10, 9, 8, 14, 13, 12, -1, -1, -1, -1);
+        unsigned char* start = out;
+        // Each step stores 32 bytes but produces 24 of them - see decodeSsse3 for why the extra bytes are safe
+        for (; length >= 48; in += 32, out += 24, length -= 32)
+        {
+            __m256i chars = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(in));
+            __m256i high = _mm256_and_si256(_mm256_srli_epi32(chars, 4), lowNibble);
+            __m256i invalid = _mm256_and_si256(_mm256_shuffle_epi8(validLow, _mm256_and_si256(chars, lowNibble)),
+                                               _mm256_shuffle_epi8(validHigh, high));
+            if (!_mm256_testz_si256(invalid, invalid))
+                break;
+            __m256i slash = _mm256_cmpeq_epi8(chars, _mm256_set1_epi8('/'));
+            __m256i values = _mm256_add_epi8(chars, _mm256_shuffle_epi8(offsets, _mm256_add_epi8(slash, high)));
+            __m256i pairs = _mm256_maddubs_epi16(values, _mm256_set1_epi32(0x01400140));
+            __m256i triples = _mm256_shuffle_epi8(_mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00011000)), pack);
+            triples = _mm256_permutevar8x32_epi32(triples, _mm256_setr_epi32(0, 1, 2, 4, 5, 6, 3, 7));
+            _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), triples);
+        }
+        return (out - start) + decodeSsse3(in, length, out);
+    }
+#endif
 
+    struct Base64Backend
+    {
+        const char* name;
+        void (*encode)(const unsigned char*, size_t, char*);
+        size_t (*decode)(const unsigned char*, size_t, unsigned char*);
+    };
+
+    const Base64Backend& activeBackend()
+    {
+        static const Base64Backend backend = [] {
+#ifdef BASE64_HAVE_SIMD
+            __builtin_cpu_init();
+            if (__builtin_cpu_supports("avx2"))
+                return Base64Backend{"avx2", encodeAvx2, decodeAvx2};
+            if (__builtin_cpu_supports("ssse3"))
+                return Base64Backend{"ssse3", encodeSsse3, decodeSsse3};
+#endif
+            return Base64Backend{"scalar", encodeScalar, decodeScalar};
+        }();
+        return backend;
+    }
+}
+
+
+std::string Base64Wrapper::encode(const std::string &str) {
+    std::string encoded(encodedLength(str.size()), '\0');
+    encode(str.data(), str.size(), &encoded[0]);
     return encoded;
 }
 
 std::string Base64Wrapper::decode(const std::string &str) {
-    std::string decoded;
-    CryptoPP::StringSource ss(str, true,
-                              new CryptoPP::Base64Decoder(
-                                      new CryptoPP::StringSink(decoded)
-                              ) // Base64Decoder
-    ); // StringSource
-
+    std::string decoded(maxDecodedLength(str.size()), '\0');
+    decoded.resize(decode(str.data(), str.size(), &decoded[0]));
     return decoded;
 }
+
+size_t Base64Wrapper::encodedLength(size_t length) {
+    return (length + 2) / 3 * 4;
+}
+
+size_t Base64Wrapper::maxDecodedLength(size_t length) {
+    return (length + 3) / 4 * 3;
+}
+
+// out must hold encodedLength(length) characters; no terminator is written
+void Base64Wrapper::encode(const char* in, size_t length, char* out) {
+    activeBackend().encode(reinterpret_cast<const unsigned char*>(in), length, out);
+}
+
+// out must hold maxDecodedLength(length) bytes; returns the number of bytes decoded, throws std::invalid_argument on
+// malformed input. Whitespace is ignored.
+size_t Base64Wrapper::decode(const char* in, size_t length, char* out) {
+    return activeBackend().decode(reinterpret_cast<const unsigned char*>(in), length,
+                                  reinterpret_cast<unsigned char*>(out));
+}
+
+const char* Base64Wrapper::backendName() {
+    return activeBackend().name;
+}
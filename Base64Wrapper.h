@@ -6,14 +6,22 @@
 #define DEFENSIVE_MAMAN_15_BASE64WRAPPER_H
 
 #include <string>
-#include "cryptopp/base64.h"
+#include <cstddef>
 
 
+// Standard Base64 (RFC 4648, with padding) without line breaks. Encoding and decoding use SSSE3 / AVX2 when the CPU
+// supports them.
 class Base64Wrapper
 {
 public:
     static std::string encode(const std::string& str);
     static std::string decode(const std::string& str);
+
+    static size_t encodedLength(size_t length);
+    static size_t maxDecodedLength(size_t length);
+    static void encode(const char* in, size_t length, char* out);
+    static size_t decode(const char* in, size_t length, char* out);
+    static const char* backendName();
 };
 
 
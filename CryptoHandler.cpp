@@ -3,11 +3,18 @@
  * Date: 04.11.2023
  * Purpose: Handle all "crypto" related stuff in the client-side utilizing the provided wrappers and checksum code.
  */
-#include <sstream>
+#include <cstring>
+#include <stdexcept>
 #include "CryptoHandler.h"
 #include "AESWrapper.h"
 #include "RSAWrapper.h"
+#include "X25519Wrapper.h"
 #include "checksum.h"
+#include "hexencode.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <vector>
+#include <exception>
 
 CryptoHandler::CryptoHandler() = default;
 CryptoHandler::~CryptoHandler() = default;
@@ -21,6 +28,15 @@ std::pair<std::string, std::string> CryptoHandler::generate_rsa_key_pair() {
     return {rsaPrivate.getPublicKey(), rsaPrivate.getPrivateKey()};
 }
 
+/**
+ * Generates a pair of X25519 keys (public and private).
+ * @return A pair containing the raw 32 byte public key and private key as strings.
+ */
+std::pair<std::string, std::string> CryptoHandler::generate_x25519_key_pair() {
+    X25519Wrapper x25519;
+    return {x25519.getPublicKey(), x25519.getPrivateKey()};
+}
+
 /**
  * Encrypts a plaintext string using AES encryption with a specified key.
  * @param plaintext The input string to encrypt.
@@ -37,12 +53,245 @@ std::string CryptoHandler::encrypt_with_aes(const std::string& plaintext, const
     std::string encrypted = aesWrapper.encrypt(plaintext.c_str(), plaintext.length());
 
     // Convert encrypted message to hexadecimal format
-    std::ostringstream oss;
-    for (unsigned char c : encrypted) {
-        oss << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
+    std::string encrypted_hex(2 * encrypted.size(), '\0');
+    hexEncode(encrypted.data(), encrypted.size(), &encrypted_hex[0]);
+    return encrypted_hex;
+}
+
+/**
+ * Creates an AES cipher context bound to a key. The context keeps its key schedule and mode objects, so it can be
+ * reused for every encryption performed with that key.
+ * @param aes_key The AES key as a string, which must be exactly 16 bytes long.
+ * @throws std::invalid_argument If the key length is not 16 bytes.
+ * @return The cipher context.
+ */
+std::unique_ptr<AESWrapper> CryptoHandler::create_aes_cipher(const std::string& aes_key) {
+    if (aes_key.length() != 16) {  // AES-128 key length is 16 bytes
+        throw std::invalid_argument("Key length must be 16 bytes.");
+    }
+    return std::make_unique<AESWrapper>(reinterpret_cast<const unsigned char*>(aes_key.c_str()), 16);
+}
+
+/**
+ * Calculates the exact size of encrypted file content as it appears on the wire.
+ * @param plaintext_size The size of the plaintext in bytes.
+ * @param encoding The content encoding negotiated with the server.
+ * @return The number of bytes encrypt_stream_with_aes will write for a plaintext of that size.
+ */
+size_t CryptoHandler::encrypted_content_size(size_t plaintext_size, ContentEncoding encoding) {
+    if (encoding == ContentEncoding::SEGMENTED_GCM) {
+        size_t segments = gcm_segment_count(plaintext_size);
+        return GCM_CONTENT_HEADER_SIZE + plaintext_size + segments * AESWrapper::GCM_TAG_LENGTH;
+    }
+    size_t cipher_size = AESWrapper::cipherLength(plaintext_size);
+    return encoding == ContentEncoding::HEX ? 2 * cipher_size : cipher_size;
+}
+
+/**
+ * Encrypts a plaintext stream using AES encryption with a specified key, calculating the CRC of the plaintext in the
+ * same pass - every chunk read from the stream is fed to both the CRC and the cipher, so the input is read only once.
+ * Cipher blocks are written straight into the caller's buffer as they come out of the cipher, either raw or hex
+ * encoded, so no intermediate copy of the content is made.
+ * @param plaintext The input stream to encrypt, read until its end.
+ * @param aes_key The AES key as a string, which must be exactly 16 bytes long.
+ * @param encoding Whether to write the cipher text as raw bytes or as hex text.
+ * @param out The buffer to write the encrypted content into.
+ * @param capacity The size of the output buffer, normally encrypted_content_size of the plaintext size.
+ * @param outCrc The POSIX cksum value of the plaintext will be stored here.
+ * @throws std::invalid_argument If the key length is not 16 bytes.
+ * @throws std::length_error If the encrypted content does not fit in the output buffer.
+ * @throws std::runtime_error If reading the stream fails.
+ * @return The number of bytes written into the output buffer.
+ */
+size_t CryptoHandler::encrypt_stream_with_aes(std::istream& plaintext, const std::string& aes_key, ContentEncoding encoding,
+                                              char* out, size_t capacity, uint32_t& outCrc) {
+    std::unique_ptr<AESWrapper> cipher = create_aes_cipher(aes_key);
+    return encrypt_stream_with_aes(plaintext, *cipher, encoding, out, capacity, outCrc);
+}
+
+/**
+ * Same as the key based overload, but runs on an existing AES cipher context, reusing its key schedule and mode
+ * objects - this is what a session uses for every file it sends with the same AES key.
+ * @param plaintext The input stream to encrypt, read until its end.
+ * @param cipher The AES cipher context to encrypt with.
+ * @param encoding Whether to write the cipher text as raw bytes or as hex text.
+ * @param out The buffer to write the encrypted content into.
+ * @param capacity The size of the output buffer, normally encrypted_content_size of the plaintext size.
+ * @param outCrc The POSIX cksum value of the plaintext will be stored here.
+ * @throws std::length_error If the encrypted content does not fit in the output buffer.
+ * @throws std::runtime_error If reading the stream fails.
+ * @return The number of bytes written into the output buffer.
+ */
+size_t CryptoHandler::encrypt_stream_with_aes(std::istream& plaintext, AESWrapper& cipher, ContentEncoding encoding,
+                                              char* out, size_t capacity, uint32_t& outCrc) {
+    if (encoding == ContentEncoding::SEGMENTED_GCM) {
+        throw std::invalid_argument("Segmented GCM content is produced by encrypt_stream_with_aes_gcm.");
     }
+    CrcState crc = crcInit();
+    size_t written = 0;
+    size_t expansion = encoding == ContentEncoding::HEX ? 2 : 1;
+    cipher.encrypt(plaintext,
+                   [&crc](const char* chunk, size_t length) { crcUpdate(crc, chunk, length); },
+                   [&](const char* chunk, size_t length) {
+                       if (expansion * length > capacity - written) {
+                           throw std::length_error("Encrypted content exceeds the output buffer.");
+                       }
+                       if (encoding == ContentEncoding::HEX) {
+                           hexEncode(chunk, length, out + written);
+                       } else {
+                           std::memcpy(out + written, chunk, length);
+                       }
+                       written += expansion * length;
+                   });
+    outCrc = crcFinalize(crc);
+    return written;
+}
+
+/**
+ * Writes a 32-bit value in big-endian (network) byte order.
+ */
+static void store_big_endian32(unsigned char* out, uint32_t value) {
+    out[0] = static_cast<unsigned char>(value >> 24);
+    out[1] = static_cast<unsigned char>(value >> 16);
+    out[2] = static_cast<unsigned char>(value >> 8);
+    out[3] = static_cast<unsigned char>(value);
+}
+
+/**
+ * Gets the number of segments a plaintext is split into in the SEGMENTED_GCM content layout.
+ * @param plaintext_size The size of the plaintext in bytes.
+ * @return The number of segments - an empty plaintext still has one (empty) segment.
+ */
+size_t CryptoHandler::gcm_segment_count(size_t plaintext_size) {
+    return plaintext_size == 0 ? 1 : (plaintext_size + GCM_SEGMENT_SIZE - 1) / GCM_SEGMENT_SIZE;
+}
 
-    return oss.str();
+/**
+ * Writes the SEGMENTED_GCM content header (see ContentEncoding) - the segment size and a fresh random nonce prefix.
+ * @param cipher The AES cipher context the content will be encrypted with.
+ * @param header The buffer to write the header into, GCM_CONTENT_HEADER_SIZE bytes long.
+ */
+void CryptoHandler::start_gcm_content(AESWrapper& cipher, char* header) {
+    auto* out = reinterpret_cast<unsigned char*>(header);
+    store_big_endian32(out, static_cast<uint32_t>(GCM_SEGMENT_SIZE));
+    cipher.generateIV(out + 4, GCM_CONTENT_HEADER_SIZE - 4);
+}
+
+/**
+ * Encrypts a run of consecutive SEGMENTED_GCM segments, read from the current position of a plaintext stream. The
+ * stream is read once, a batch of segments at a time, and every segment of a batch is encrypted, authenticated and
+ * checksummed on the thread pool in parallel, straight into its final position in the output buffer. The partial
+ * CRCs are merged in order, so feeding all segments through the same CRC state yields the CRC of the whole plaintext.
+ * @param plaintext The input stream, positioned at the start of the first segment.
+ * @param plaintext_size The size of the whole plaintext, which determines the segments' lengths.
+ * @param first_segment The index of the first segment to encrypt.
+ * @param segment_count The number of segments to encrypt.
+ * @param cipher The AES cipher context to encrypt with.
+ * @param header The content header written by start_gcm_content.
+ * @param pool The thread pool to encrypt the segments on.
+ * @param buffers The caller's segment buffers, grown to a batch's worth if they are fewer.
+ * @param out The buffer to write the encrypted segments into.
+ * @param crc The running CRC of the plaintext, updated with the segments' plaintext.
+ * @throws std::runtime_error If reading the stream fails or it ends early.
+ * @return The number of bytes written into the output buffer.
+ */
+size_t CryptoHandler::encrypt_gcm_segments(std::istream& plaintext, size_t plaintext_size, size_t first_segment,
+                                           size_t segment_count, const AESWrapper& cipher, const char* header,
+                                           ThreadPool& pool, GcmSegmentBuffers& buffers, char* out, CrcState& crc) {
+    size_t segments = gcm_segment_count(plaintext_size);
+    size_t end_segment = std::min(segments, first_segment + segment_count);
+    size_t batch_size = 2 * static_cast<size_t>(pool.size());
+    size_t needed = std::min(batch_size, end_segment - first_segment);
+    if (buffers.size() < needed) {
+        buffers.resize(needed, std::vector<char>(GCM_SEGMENT_SIZE));
+    }
+    std::vector<std::future<CrcState>> pending;
+    const AESWrapper& gcm = cipher;
+    const auto* nonce_prefix = reinterpret_cast<const unsigned char*>(header + 4);
+    size_t written = 0;
+
+    bool read_failed = false;
+    for (size_t first = first_segment; first < end_segment && !read_failed; first += batch_size) {
+        size_t last = std::min(end_segment, first + batch_size);
+        pending.clear();
+        for (size_t index = first; index < last; ++index) {
+            std::vector<char>& buffer = buffers[index - first];
+            size_t length = std::min(GCM_SEGMENT_SIZE, plaintext_size - index * GCM_SEGMENT_SIZE);
+            if (!plaintext.read(buffer.data(), static_cast<std::streamsize>(length))) {
+                read_failed = true;
+                break;
+            }
+            char* segment_out = out + written;
+            written += length + AESWrapper::GCM_TAG_LENGTH;
+            bool is_last = index + 1 == segments;
+
+            pending.push_back(pool.submit([&gcm, &buffer, nonce_prefix, index, length, segment_out, is_last]() {
+                unsigned char nonce[AESWrapper::GCM_NONCE_LENGTH];
+                std::memcpy(nonce, nonce_prefix, GCM_CONTENT_HEADER_SIZE - 4);
+                store_big_endian32(nonce + 8, static_cast<uint32_t>(index));
+                unsigned char aad[5];
+                store_big_endian32(aad, static_cast<uint32_t>(index));
+                aad[4] = is_last ? 1 : 0;
+
+                gcm.encryptGcm(nonce, aad, sizeof(aad), buffer.data(), length, segment_out,
+                               reinterpret_cast<unsigned char*>(segment_out + length));
+                CrcState segment_crc = crcInit();
+                crcUpdate(segment_crc, buffer.data(), length);
+                return segment_crc;
+            }));
+        }
+        // The batch's buffers are reused by the next batch, so wait for all of it before reading on (or bailing out)
+        std::exception_ptr failure;
+        for (std::future<CrcState>& segment_crc : pending) {
+            try {
+                crc = crcCombine(crc, segment_crc.get());
+            } catch (...) {
+                failure = failure ? failure : std::current_exception();
+            }
+        }
+        if (failure) {
+            std::rethrow_exception(failure);
+        }
+    }
+
+    if (read_failed) {
+        throw std::runtime_error("Failed reading plain text stream.");
+    }
+    return written;
+}
+
+/**
+ * Encrypts a whole plaintext stream into the SEGMENTED_GCM content layout (see ContentEncoding) - the content header
+ * followed by every segment, encrypted in parallel by encrypt_gcm_segments.
+ * @param plaintext The input stream to encrypt, read until its end.
+ * @param plaintext_size The exact number of bytes the stream holds.
+ * @param cipher The AES cipher context to encrypt with.
+ * @param pool The thread pool to encrypt the segments on.
+ * @param buffers The caller's segment buffers (see encrypt_gcm_segments).
+ * @param out The buffer to write the encrypted content into.
+ * @param capacity The size of the output buffer, which must be encrypted_content_size of the plaintext size.
+ * @param outCrc The POSIX cksum value of the plaintext will be stored here.
+ * @throws std::length_error If the output buffer does not match the plaintext size, or the stream holds more data.
+ * @throws std::runtime_error If reading the stream fails or it ends early.
+ * @return The number of bytes written into the output buffer.
+ */
+size_t CryptoHandler::encrypt_stream_with_aes_gcm(std::istream& plaintext, size_t plaintext_size, AESWrapper& cipher,
+                                                  ThreadPool& pool, GcmSegmentBuffers& buffers, char* out,
+                                                  size_t capacity, uint32_t& outCrc) {
+    if (capacity != encrypted_content_size(plaintext_size, ContentEncoding::SEGMENTED_GCM)) {
+        throw std::length_error("Output buffer does not match the encrypted content size.");
+    }
+
+    start_gcm_content(cipher, out);
+    CrcState crc = crcInit();
+    encrypt_gcm_segments(plaintext, plaintext_size, 0, gcm_segment_count(plaintext_size), cipher, out, pool,
+                         buffers, out + GCM_CONTENT_HEADER_SIZE, crc);
+
+    if (plaintext.peek() != std::char_traits<char>::eof()) {
+        throw std::length_error("Plain text stream holds more data than expected.");
+    }
+    outCrc = crcFinalize(crc);
+    return capacity;
 }
 
 /**
@@ -55,3 +304,59 @@ std::string CryptoHandler::decrypt_with_rsa(const std::string& ciphertext, const
     RSAPrivateWrapper rsaPrivate(private_key);
     return rsaPrivate.decrypt(ciphertext);
 }
+
+/**
+ * Creates an RSA decryption context from a serialized private key. The key is parsed and the OAEP decryptor is built
+ * once, so the context can be kept and reused for every ciphertext sent to that identity.
+ * @param private_key The RSA private key as a string.
+ * @return The decryption context.
+ */
+std::unique_ptr<RSAPrivateWrapper> CryptoHandler::create_rsa_decryptor(const std::string& private_key) {
+    return std::make_unique<RSAPrivateWrapper>(private_key);
+}
+
+/**
+ * Decrypts a ciphertext string using an already parsed RSA decryption context.
+ * @param ciphertext The encrypted string to decrypt.
+ * @param decryptor The decryption context created by create_rsa_decryptor.
+ * @return The decrypted string.
+ */
+std::string CryptoHandler::decrypt_with_rsa(const std::string& ciphertext, const RSAPrivateWrapper& decryptor) {
+    return decryptor.decrypt(ciphertext);
+}
+
+/**
+ * Unwraps an AES key the server sealed for the client's X25519 public key (see X25519Wrapper for the layout).
+ * @param wrapped_key The wrapped AES key received from the server.
+ * @param private_key The X25519 private key as a string.
+ * @throws std::length_error If the wrapped key or private key has an invalid length.
+ * @throws std::runtime_error If the wrapped key fails authentication.
+ * @return The AES key.
+ */
+std::string CryptoHandler::unwrap_with_x25519(const std::string& wrapped_key, const std::string& private_key) {
+    X25519Wrapper x25519(private_key);
+    return x25519.unwrap(wrapped_key);
+}
+
+/**
+ * Decrypts the AES key the server sent a client, with the key exchange the client's private key belongs to - an
+ * X25519 unwrap, or an RSA decryption through the session's cached decryption context, rebuilt only when the private
+ * key differs from the one it was built for.
+ * @param encrypted_aes_key The AES key received from the server.
+ * @param key_type The type of the client's private key.
+ * @param private_key The client's private key.
+ * @param rsa_cache The session's RSA decryption context.
+ * @throws std::exception If the key can't be parsed, or the AES key can't be decrypted with it.
+ * @return The AES key.
+ */
+std::string CryptoHandler::decrypt_aes_key(const std::string& encrypted_aes_key, KeyType key_type,
+                                           const std::string& private_key, RSADecryptorCache& rsa_cache) {
+    if (key_type == KeyType::X25519) {
+        return unwrap_with_x25519(encrypted_aes_key, private_key);
+    }
+    if (!rsa_cache.decryptor || private_key != rsa_cache.privateKey) {
+        rsa_cache.decryptor = create_rsa_decryptor(private_key);
+        rsa_cache.privateKey = private_key;
+    }
+    return decrypt_with_rsa(encrypted_aes_key, *rsa_cache.decryptor);
+}
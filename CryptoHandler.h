@@ -8,6 +8,50 @@
 
 #include <string>
 #include <utility>
+#include <istream>
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include "checksum.h"
+
+class AESWrapper;
+class RSAPrivateWrapper;
+class ThreadPool;
+
+// How encrypted file content is laid out in a SEND_FILE payload - AES-CBC hex text for servers speaking
+// PROTOCOL_VERSION, raw AES-CBC bytes for servers that advertise BINARY_CONTENT_PROTOCOL_VERSION, and independently
+// authenticated AES-GCM segments for servers that advertise SEGMENTED_GCM_PROTOCOL_VERSION:
+//   segment size (4 bytes, big-endian) | nonce prefix (8 bytes) | segment 0 cipher text | tag 0 | segment 1 ...
+// Every segment but the last holds GCM_SEGMENT_SIZE bytes. Segment i is encrypted under the nonce
+// (nonce prefix | i as 4 big-endian bytes) and authenticates (i as 4 big-endian bytes | 1 if last else 0), so
+// segments can be neither reordered nor dropped.
+enum class ContentEncoding {
+    HEX,
+    BINARY,
+    SEGMENTED_GCM
+};
+
+constexpr size_t GCM_SEGMENT_SIZE = 1 << 20;
+constexpr size_t GCM_CONTENT_HEADER_SIZE = 4 + 8;
+
+// The plaintext buffers a batch of segments is read into, GCM_SEGMENT_SIZE bytes each. A session keeps its own and
+// passes it to every encryption it runs, so the buffers are allocated by its first file only.
+using GcmSegmentBuffers = std::vector<std::vector<char>>;
+
+// The key exchange a client's private key belongs to. It is persisted along with the key (see FileHandler), so the
+// type of a stored key is never guessed from its size.
+enum class KeyType {
+    RSA,
+    X25519
+};
+
+// An RSA decryption context, kept along with the private key it was built for. A session keeps its own and passes it
+// to every AES key decryption, so its private key is only parsed again when it changes.
+struct RSADecryptorCache {
+    std::unique_ptr<RSAPrivateWrapper> decryptor;
+    std::string privateKey;
+};
 
 class CryptoHandler {
 public:
@@ -15,8 +59,28 @@ public:
     ~CryptoHandler();
 
     static std::pair<std::string, std::string> generate_rsa_key_pair();
+    static std::pair<std::string, std::string> generate_x25519_key_pair();
     static std::string encrypt_with_aes(const std::string& plaintext, const std::string& aes_key);
+    static size_t encrypted_content_size(size_t plaintext_size, ContentEncoding encoding);
+    static std::unique_ptr<AESWrapper> create_aes_cipher(const std::string& aes_key);
+    static size_t encrypt_stream_with_aes(std::istream& plaintext, const std::string& aes_key, ContentEncoding encoding,
+                                          char* out, size_t capacity, uint32_t& outCrc);
+    static size_t encrypt_stream_with_aes(std::istream& plaintext, AESWrapper& cipher, ContentEncoding encoding,
+                                          char* out, size_t capacity, uint32_t& outCrc);
+    static size_t gcm_segment_count(size_t plaintext_size);
+    static void start_gcm_content(AESWrapper& cipher, char* header);
+    static size_t encrypt_gcm_segments(std::istream& plaintext, size_t plaintext_size, size_t first_segment,
+                                       size_t segment_count, const AESWrapper& cipher, const char* header,
+                                       ThreadPool& pool, GcmSegmentBuffers& buffers, char* out, CrcState& crc);
+    static size_t encrypt_stream_with_aes_gcm(std::istream& plaintext, size_t plaintext_size, AESWrapper& cipher,
+                                              ThreadPool& pool, GcmSegmentBuffers& buffers, char* out,
+                                              size_t capacity, uint32_t& outCrc);
+    static std::unique_ptr<RSAPrivateWrapper> create_rsa_decryptor(const std::string& private_key);
     static std::string decrypt_with_rsa(const std::string& ciphertext, const std::string& private_key);
+    static std::string decrypt_with_rsa(const std::string& ciphertext, const RSAPrivateWrapper& decryptor);
+    static std::string unwrap_with_x25519(const std::string& wrapped_key, const std::string& private_key);
+    static std::string decrypt_aes_key(const std::string& encrypted_aes_key, KeyType key_type,
+                                       const std::string& private_key, RSADecryptorCache& rsa_cache);
 };
 
 
@@ -0,0 +1,138 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Dispatch socket readiness events to their handlers, so a single thread can drive many sessions.
+ */
+#include "EventLoop.h"
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <cerrno>
+#include <system_error>
+
+/**
+ * Creates the loop's epoll instance, and the eventfd other threads wake it up with.
+ * @throws std::system_error If either can't be created.
+ */
+EventLoop::EventLoop() : epoll_(epoll_create1(EPOLL_CLOEXEC)), wakeup_(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {
+    if (epoll_ == -1 || wakeup_ == -1) {
+        int error = errno;
+        close(epoll_);
+        close(wakeup_);
+        throw std::system_error(error, std::system_category(), "Failed to create an epoll instance");
+    }
+    add(wakeup_, EPOLLIN, this);
+    registered_--;  // The wakeup descriptor alone doesn't keep the loop running
+}
+
+EventLoop::~EventLoop() {
+    close(wakeup_);
+    close(epoll_);
+}
+
+/**
+ * Starts watching a descriptor.
+ * @param fd The descriptor to watch.
+ * @param events The events to wait for (EPOLLIN, EPOLLOUT).
+ * @param handler The handler to dispatch the descriptor's events to.
+ * @throws std::system_error If the descriptor can't be watched.
+ */
+void EventLoop::add(int fd, uint32_t events, EventHandler* handler) {
+    epoll_event event{};
+    event.events = events;
+    event.data.ptr = handler;
+    if (epoll_ctl(epoll_, EPOLL_CTL_ADD, fd, &event) == -1) {
+        throw std::system_error(errno, std::system_category(), "Failed to watch a descriptor");
+    }
+    registered_++;
+}
+
+/**
+ * Changes the events a watched descriptor is waited for.
+ * @param fd The watched descriptor.
+ * @param events The events to wait for from now on.
+ * @param handler The handler to dispatch the descriptor's events to.
+ * @throws std::system_error If the descriptor isn't watched.
+ */
+void EventLoop::modify(int fd, uint32_t events, EventHandler* handler) {
+    epoll_event event{};
+    event.events = events;
+    event.data.ptr = handler;
+    if (epoll_ctl(epoll_, EPOLL_CTL_MOD, fd, &event) == -1) {
+        throw std::system_error(errno, std::system_category(), "Failed to modify a watched descriptor");
+    }
+}
+
+/**
+ * Stops watching a descriptor. Must be called before the descriptor is closed.
+ * @param fd The watched descriptor.
+ */
+void EventLoop::remove(int fd) {
+    if (epoll_ctl(epoll_, EPOLL_CTL_DEL, fd, nullptr) == 0) {
+        registered_--;
+    }
+}
+
+/**
+ * Queues a callback to run on the loop's thread. Safe to call from any thread.
+ * @param callback The callback to run.
+ */
+void EventLoop::post(std::function<void()> callback) {
+    {
+        std::lock_guard<std::mutex> lock(postedMutex_);
+        posted_.push_back(std::move(callback));
+    }
+    uint64_t one = 1;
+    (void)write(wakeup_, &one, sizeof(one));
+}
+
+/**
+ * Keeps the loop running while work that will post back to it is in flight, even if no descriptor is watched.
+ */
+void EventLoop::retain() {
+    retained_++;
+}
+
+/**
+ * Releases a retain() once the work it was made for has posted back.
+ */
+void EventLoop::release() {
+    retained_--;
+}
+
+/**
+ * Runs the callbacks posted since the loop last woke up. The wakeup descriptor is only ever readable, so its events
+ * are ignored.
+ */
+void EventLoop::onEvents(uint32_t) {
+    uint64_t count;
+    (void)read(wakeup_, &count, sizeof(count));
+    std::vector<std::function<void()>> posted;
+    {
+        std::lock_guard<std::mutex> lock(postedMutex_);
+        posted.swap(posted_);
+    }
+    for (auto& callback : posted) {
+        callback();
+    }
+}
+
+/**
+ * Dispatches events until no descriptor is watched and no retained work is in flight anymore.
+ * @throws std::system_error If waiting for events fails.
+ */
+void EventLoop::run() {
+    epoll_event events[MAX_EVENTS];
+    while (registered_ > 0 || retained_ > 0) {
+        int ready = epoll_wait(epoll_, events, MAX_EVENTS, -1);
+        if (ready == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category(), "Failed waiting for events");
+        }
+        for (int i = 0; i < ready; ++i) {
+            static_cast<EventHandler*>(events[i].data.ptr)->onEvents(events[i].events);
+        }
+    }
+}
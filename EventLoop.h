@@ -0,0 +1,54 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for EventLoop.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_EVENTLOOP_H
+#define DEFENSIVE_MAMAN_15_EVENTLOOP_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+// Receives the readiness events of a descriptor registered with an EventLoop.
+class EventHandler {
+public:
+    virtual ~EventHandler() = default;
+    virtual void onEvents(uint32_t events) = 0;
+};
+
+// A level-triggered epoll loop. Handlers are not owned by the loop, and must outlive their registration. Other
+// threads hand work back to the loop's thread through post(), e.g. when work offloaded to a thread pool completes.
+class EventLoop : private EventHandler {
+public:
+    EventLoop();
+    ~EventLoop();
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    void add(int fd, uint32_t events, EventHandler* handler);
+    void modify(int fd, uint32_t events, EventHandler* handler);
+    void remove(int fd);
+    void post(std::function<void()> callback);
+    void retain();
+    void release();
+    void run();
+
+private:
+    static const int MAX_EVENTS = 256;
+
+    int epoll_;
+    int wakeup_;
+    size_t registered_ = 0;
+    std::atomic<size_t> retained_{0};  // Work in flight elsewhere that will post back to the loop
+    std::mutex postedMutex_;
+    std::vector<std::function<void()>> posted_;
+
+    void onEvents(uint32_t events) override;
+};
+
+
+#endif
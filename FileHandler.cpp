@@ -6,6 +6,10 @@
 #include "FileHandler.h"
 #include "constants.h"
 #include "Base64Wrapper.h"
+#include <iomanip>
+#include <filesystem>
+#include <unistd.h>
+#include "checksum.h"
 
 /**
  * Opens a file stream for a given path and mode.
@@ -25,25 +29,45 @@ FileStream FileHandler::openFile(const std::string &path, std::ios_base::openmod
 }
 
 /**
- * Reads and returns information about the client from a predefined file.
- * @return A MeInfo structure containing the client's name, UUID, and base64-encoded key.
+ * Gets the marker a key type is persisted with, in me.info and priv.key.
+ * @param keyType The key type.
+ * @return The key type's marker.
+ */
+const char* FileHandler::keyTypeName(KeyType keyType) {
+    return keyType == KeyType::X25519 ? "X25519" : "RSA";
+}
+
+/**
+ * Reads and returns information about the client from a predefined file. A me.info without a key type row was saved
+ * before X25519 keys existed, so its key is an RSA key.
+ * @throws std::runtime_error If the key type row names an unknown key type.
+ * @return A MeInfo structure containing the client's name, UUID, base64-encoded key and the key's type.
  */
 MeInfo FileHandler::readMeInfo() {
     std::string path = std::string(CLIENTS_BASE_PATH) + std::string(ME_INFO_FILE_NAME);
     auto file = openFile<std::ifstream>(path, std::ios::in);
 
     MeInfo info;
+    std::string keyType;
     std::getline(file, info.name);
     std::getline(file, info.uuid);
     std::getline(file, info.base64Key);
+    std::getline(file, keyType);
     file.close();  // Close the file after reading
+
+    if (keyType == keyTypeName(KeyType::X25519)) {
+        info.keyType = KeyType::X25519;
+    } else if (!keyType.empty() && keyType != keyTypeName(KeyType::RSA)) {
+        throw std::runtime_error("Unknown key type " + keyType + " in " + path);
+    }
     return info;
 }
 
 /**
  * Reads and returns transfer information from a predefined file.
  * @throws std::runtime_error If the name is too long or if the format for IP and port is invalid.
- * @return A TransferInfo structure containing the IP address, port, name, and file path for transfer.
+ * @return A TransferInfo structure containing the IP address, port, name, and the file paths for transfer - every line
+ *         after the name lists a file.
  */
 TransferInfo FileHandler::readTransferInfo() {
     std::string path = std::string(CLIENTS_BASE_PATH) + std::string(TRANSFER_INFO_FILE_NAME);
@@ -53,12 +77,19 @@ TransferInfo FileHandler::readTransferInfo() {
     std::string ip_port;
     std::getline(file, ip_port);
     std::getline(file, info.name);
-    std::getline(file, info.filePath);
+    for (std::string filePath; std::getline(file, filePath);) {
+        if (!filePath.empty()) {
+            info.filePaths.push_back(filePath);
+        }
+    }
     file.close();  // Close the file after reading
 
     if (info.name.length() > 254) {
         throw std::runtime_error("Invalid name, name length must be <= 254 chars.");
     }
+    if (info.filePaths.empty()) {
+        throw std::runtime_error("No file to transfer was listed in " + path);
+    }
 
     // Split the ip_port string to extract IP and port
     size_t pos = ip_port.find(':');
@@ -87,12 +118,15 @@ void FileHandler::writeToFile(const std::string &filename, const std::string &co
  * Saves the client's information to a predefined file, utilizing the custom format specified in Maman15:
  * Row 1: Consists of Client Name.
  * Row 2: Consists of Client ID.
- * Row 3: Consists of RSA encrypted key in Base64.
+ * Row 3: Consists of the private key (RSA or X25519) in Base64.
+ * Row 4: Consists of the private key's type (RSA or X25519).
  * @param clientName The client's name.
  * @param clientId The client's unique identifier.
  * @param privateKey The client's private key.
+ * @param keyType The private key's type.
  */
-void FileHandler::saveMeInfo(const std::string& clientName, const char* clientId, const std::string& privateKey) {
+void FileHandler::saveMeInfo(const std::string& clientName, const char* clientId, const std::string& privateKey,
+                             KeyType keyType) {
     std::string path = std::string(CLIENTS_BASE_PATH) + std::string(ME_INFO_FILE_NAME);
     auto file = openFile<std::ofstream>(path, std::ios::out | std::ios::trunc);
 
@@ -105,22 +139,21 @@ void FileHandler::saveMeInfo(const std::string& clientName, const char* clientId
     }
     file << '\n';
 
-    // Write private key in base64 format
-    std::string base64PrivateKey = Base64Wrapper::encode(privateKey);
-    // Remove newline characters from the base64 encoded string
-    base64PrivateKey.erase(std::remove(base64PrivateKey.begin(), base64PrivateKey.end(), '\n'), base64PrivateKey.end());
-    file << base64PrivateKey;
+    // Write private key in base64 format (without line breaks), followed by its type
+    file << Base64Wrapper::encode(privateKey) << '\n' << keyTypeName(keyType) << '\n';
 
     file.close();
 }
 
 /**
- * Saves the private RSA key to a predefined private key file path.
- * @param privateKey The RSA private key to save.
+ * Saves the client's private key to a predefined private key file path - a row naming the key's type (RSA or X25519),
+ * followed by the serialized RSA key or the raw 32 bytes of the X25519 key, exactly as me.info holds it in Base64.
+ * @param privateKey The private key to save.
+ * @param keyType The private key's type.
  */
-void FileHandler::savePrivateRSAKey(const std::string &privateKey) {
+void FileHandler::savePrivateKey(const std::string &privateKey, KeyType keyType) {
     std::string filePath = std::string(CLIENTS_BASE_PATH) + std::string(PRIVATE_KEY_FILE);
-    writeToFile(filePath, privateKey);
+    writeToFile(filePath, std::string(keyTypeName(keyType)) + '\n' + privateKey);
 }
 
 /**
@@ -134,4 +167,145 @@ std::string FileHandler::readFileContents(const std::string& path) {
     contents << fileStream.rdbuf();
     fileStream.close();
     return contents.str();
-}
\ No newline at end of file
+}
+
+/**
+ * Opens a file for binary reading, for callers that want to consume it in chunks rather than as a whole.
+ * @param path The path to the file to open.
+ * @throws std::runtime_error If the file cannot be opened.
+ * @return The opened input file stream.
+ */
+std::ifstream FileHandler::openFileForReading(const std::string& path) {
+    return openFile<std::ifstream>(path, std::ios::in | std::ios::binary);
+}
+
+/**
+ * Gets the path of the upload journal kept for a file - one journal per uploaded file, named after its path's CRC.
+ * @param filePath The path of the uploaded file.
+ * @return The journal's path.
+ */
+std::string FileHandler::uploadJournalPath(const std::string& filePath) {
+    std::ostringstream path;
+    path << CLIENTS_BASE_PATH << UPLOAD_JOURNAL_PREFIX << std::hex << std::setw(8) << std::setfill('0')
+         << memcrc(const_cast<char*>(filePath.data()), filePath.size()) << ".journal";
+    return path.str();
+}
+
+/**
+ * Reads the upload journal kept for a file, if there is one.
+ * @param filePath The path of the uploaded file.
+ * @param journal The journal's content will be stored here.
+ * @return True if a complete journal for that file was read, false otherwise.
+ */
+bool FileHandler::readUploadJournal(const std::string& filePath, UploadJournal& journal) {
+    std::ifstream file(uploadJournalPath(filePath));
+    if (!file) {
+        return false;
+    }
+    std::string clientIdHex, wrappedAesKey, contentHeader;
+    std::getline(file, journal.filePath);
+    file >> journal.fileSize >> journal.fileModified >> journal.fileInode >> journal.fileChanged >> clientIdHex >> wrappedAesKey >> contentHeader
+         >> journal.offset >> journal.nextSegment >> journal.crc >> journal.crcLength;
+    if (file.fail() || journal.filePath != filePath || clientIdHex.size() != 32 ||
+        clientIdHex.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+        return false;
+    }
+    journal.clientId.resize(16);
+    for (size_t i = 0; i < 16; ++i) {
+        journal.clientId[i] = static_cast<char>(std::stoi(clientIdHex.substr(2 * i, 2), nullptr, 16));
+    }
+    try {
+        journal.wrappedAesKey = Base64Wrapper::decode(wrappedAesKey);
+        journal.contentHeader = Base64Wrapper::decode(contentHeader);
+    } catch (const std::invalid_argument&) {
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Saves an upload journal, replacing the previous one atomically - so a crash while saving leaves either the old or
+ * the new checkpoint behind, never a torn one.
+ * @param journal The journal to save.
+ */
+void FileHandler::saveUploadJournal(const UploadJournal& journal) {
+    std::string path = uploadJournalPath(journal.filePath);
+    std::string temporaryPath = path + ".tmp";
+    {
+        auto file = openFile<std::ofstream>(temporaryPath, std::ios::out | std::ios::trunc);
+        file << journal.filePath << '\n'
+             << journal.fileSize << ' ' << journal.fileModified << ' ' << journal.fileInode << ' '
+             << journal.fileChanged << '\n'
+             << std::hex << std::setfill('0');
+        for (char byte : journal.clientId) {
+            file << std::setw(2) << (static_cast<int>(byte) & 0xFF);
+        }
+        file << std::dec << '\n'
+             << Base64Wrapper::encode(journal.wrappedAesKey) << '\n'
+             << Base64Wrapper::encode(journal.contentHeader) << '\n'
+             << journal.offset << ' ' << journal.nextSegment << ' ' << journal.crc << ' ' << journal.crcLength << '\n';
+        if (!file.flush()) {
+            throw std::runtime_error("Unable to write " + temporaryPath);
+        }
+    }
+    std::filesystem::rename(temporaryPath, path);
+}
+
+/**
+ * Removes the upload journal kept for a file, if there is one.
+ * @param filePath The path of the uploaded file.
+ */
+void FileHandler::removeUploadJournal(const std::string& filePath) {
+    std::error_code error;
+    std::filesystem::remove(uploadJournalPath(filePath), error);
+}
+
+/**
+ * Takes the RSA key pairs a previous run left in stock, removing them from disk - the stock is claimed by renaming it
+ * first, so two clients starting together never take the same pairs.
+ * @return The key pairs (public key, private key) in stock, empty if there are none.
+ */
+std::vector<std::pair<std::string, std::string>> FileHandler::takeKeyStock() {
+    std::string path = std::string(CLIENTS_BASE_PATH) + RSA_KEY_STOCK_FILE;
+    std::string claimedPath = path + "." + std::to_string(getpid());
+    std::error_code error;
+    std::filesystem::rename(path, claimedPath, error);
+    if (error) {
+        return {};
+    }
+    std::vector<std::pair<std::string, std::string>> keyPairs;
+    {
+        std::ifstream file(claimedPath);
+        std::string publicKey, privateKey;
+        while (file >> publicKey >> privateKey) {
+            try {
+                keyPairs.emplace_back(Base64Wrapper::decode(publicKey), Base64Wrapper::decode(privateKey));
+            } catch (const std::invalid_argument&) {
+                // Skip a torn pair, the rest of the stock is still good
+            }
+        }
+    }
+    std::filesystem::remove(claimedPath, error);
+    return keyPairs;
+}
+
+/**
+ * Saves RSA key pairs in stock for the next run, one pair per row (public key and private key, in Base64), readable
+ * by the owner only. Replaces the stock atomically, like the upload journal.
+ * @param keyPairs The key pairs (public key, private key) to save.
+ */
+void FileHandler::saveKeyStock(const std::vector<std::pair<std::string, std::string>>& keyPairs) {
+    std::string path = std::string(CLIENTS_BASE_PATH) + RSA_KEY_STOCK_FILE;
+    std::string temporaryPath = path + ".tmp";
+    {
+        auto file = openFile<std::ofstream>(temporaryPath, std::ios::out | std::ios::trunc);
+        std::filesystem::permissions(temporaryPath, std::filesystem::perms::owner_read | std::filesystem::perms::owner_write);
+        for (const auto& [publicKey, privateKey] : keyPairs) {
+            file << Base64Wrapper::encode(publicKey) << ' ' << Base64Wrapper::encode(privateKey) << '\n';
+        }
+        if (!file.flush()) {
+            throw std::runtime_error("Unable to write " + temporaryPath);
+        }
+    }
+    std::filesystem::rename(temporaryPath, path);
+}
@@ -10,18 +10,40 @@
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "CryptoHandler.h"
 
 struct MeInfo {
     std::string name;
     std::string uuid;
     std::string base64Key;
+    KeyType keyType = KeyType::RSA;
+};
+
+// Checkpoint of a multi-part upload, updated whenever the server acknowledges a chunk. Holds everything needed to
+// continue the upload from the acknowledged offset in a later run, without re-reading what was already sent.
+struct UploadJournal {
+    std::string filePath;
+    uint64_t fileSize;
+    int64_t fileModified;
+    uint64_t fileInode;          // With the change time, tells a file replaced or rewritten in place since the upload
+    int64_t fileChanged;         // started - unlike the modification time, neither can be set back
+    std::string clientId;        // 16 raw bytes, kept in hex like in me.info
+    std::string wrappedAesKey;   // The AES key the upload is encrypted with, as the server sent it (kept in Base64)
+    std::string contentHeader;   // The SEGMENTED_GCM content header (kept in Base64)
+    uint64_t offset;             // The acknowledged number of content bytes
+    uint64_t nextSegment;        // The first segment that wasn't acknowledged
+    uint32_t crc;                // The running CRC state of the acknowledged plaintext
+    uint64_t crcLength;
 };
 
 struct TransferInfo {
     std::string ipAddress;
     int port;
     std::string name;
-    std::string filePath;
+    std::vector<std::string> filePaths;  // Every file listed after the name, all sent over a single session
 };
 
 class FileHandler {
@@ -29,10 +51,19 @@ public:
     MeInfo readMeInfo();
     TransferInfo readTransferInfo();
     void writeToFile(const std::string& filename, const std::string& content);
-    void saveMeInfo(const std::string& clientName, const char* clientId, const std::string& privateKey);
-    void savePrivateRSAKey(const std::string &privateKey);
+    void saveMeInfo(const std::string& clientName, const char* clientId, const std::string& privateKey,
+                    KeyType keyType);
+    void savePrivateKey(const std::string &privateKey, KeyType keyType);
     std::string readFileContents(const std::string& path);
+    std::ifstream openFileForReading(const std::string& path);
+    bool readUploadJournal(const std::string& filePath, UploadJournal& journal);
+    void saveUploadJournal(const UploadJournal& journal);
+    void removeUploadJournal(const std::string& filePath);
+    std::vector<std::pair<std::string, std::string>> takeKeyStock();
+    void saveKeyStock(const std::vector<std::pair<std::string, std::string>>& keyPairs);
 private:
+    static const char* keyTypeName(KeyType keyType);
+    static std::string uploadJournalPath(const std::string& filePath);
     template <typename FileStream>
     FileStream openFile(const std::string &path, std::ios_base::openmode mode);
 };
@@ -13,7 +13,8 @@
  */
 std::string Logger::getCurrentTime() {
     auto now = std::time(nullptr);
-    std::tm tm = *std::localtime(&now);
+    std::tm tm{};
+    localtime_r(&now, &tm);  // std::localtime shares its result between threads
     std::ostringstream oss;
     oss << std::put_time(&tm, "%Y-%m-%d %H:%M:%S");
     return oss.str();
@@ -38,10 +39,12 @@ std::string Logger::levelToString(Level level) {
  * @param message The message to log.
  */
 void Logger::log(Level logLevel, const std::string& message) const {
-    // Use std::cerr for ERROR level, std::cout for others
+    // Use std::cerr for ERROR level, std::cout for others. The line is formatted up front and written at once, so
+    // loggers used by concurrent sessions don't interleave their lines or contend on anything but the stream itself:
     auto& stream = logLevel == Level::ERROR ? std::cerr : std::cout;
-    stream << getCurrentTime() << " - " << name << " - "
-           << levelToString(logLevel) << " - " << message << std::endl;
+    std::ostringstream line;
+    line << getCurrentTime() << " - " << name << " - " << levelToString(logLevel) << " - " << message << '\n';
+    stream << line.str() << std::flush;
 }
 
 Logger::Logger(std::string name, Level level)
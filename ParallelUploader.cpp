@@ -0,0 +1,126 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Upload the files listed in transfer.info over several concurrent sessions, so reading, encryption and
+ * network waits of different files overlap.
+ */
+#include "ParallelUploader.h"
+#include "ProtocolHandler.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <filesystem>
+#include <future>
+#include <utility>
+#include <vector>
+
+ParallelUploader::ParallelUploader(TransferInfo transferInfo, unsigned int sessionCount)
+        : transferInfo_(std::move(transferInfo)), sessionCount_(sessionCount == 0 ? 1 : sessionCount),
+          logger_("ParallelUploader") {}
+
+/**
+ * Makes sure the client is registered (and its key pair rotated, if requested) before the sessions start. Sessions
+ * running side by side would otherwise each register the client or replace its key. This is done over a session of
+ * its own, sending no files.
+ * @param rotateKey Whether to replace the stored key pair with a new one.
+ * @param meInfo The client's stored information will be stored here.
+ * @return True if the client is registered with the server, false otherwise.
+ */
+bool ParallelUploader::prepareClient(bool rotateKey, MeInfo& meInfo) {
+    FileHandler fileHandler;
+    bool registered = true;
+    try {
+        meInfo = fileHandler.readMeInfo();
+    } catch (std::runtime_error&) {
+        registered = false;
+    }
+    if (registered && !rotateKey) {
+        return true;
+    }
+
+    ProtocolHandler protocolHandler(transferInfo_.ipAddress, transferInfo_.port,
+                                    registered ? meInfo.name : transferInfo_.name, {});
+    if (!protocolHandler.handleConnection()) {
+        return false;
+    }
+    bool status = registered ? protocolHandler.handleReconnection(meInfo.base64Key, meInfo.keyType, true)
+                             : protocolHandler.handleRegistration();
+    if (status) {
+        meInfo = fileHandler.readMeInfo();
+    }
+    return status;
+}
+
+/**
+ * Runs a single session: connects, reconnects using the stored key, and sends files taken from the shared queue
+ * until it runs dry. A session never registers the client nor replaces its key, which would race the other sessions
+ * over me.info - if the stored key can't be used, the session fails.
+ * @param session The session's number, used to tell its log lines apart.
+ * @param meInfo The client's stored information.
+ * @param workerPool The thread pool all the sessions encrypt on.
+ * @return True if every file the session took was sent, false otherwise.
+ */
+bool ParallelUploader::runSession(unsigned int session, const MeInfo& meInfo, std::shared_ptr<ThreadPool> workerPool) {
+    ProtocolHandler protocolHandler(transferInfo_.ipAddress, transferInfo_.port, meInfo.name, {},
+                                    "ProtocolHandler-" + std::to_string(session));
+    protocolHandler.shareWorkerPool(std::move(workerPool));
+    protocolHandler.setFileSource([this](std::string& filePath) {
+        size_t next = nextFile_.fetch_add(1, std::memory_order_relaxed);
+        if (next >= transferInfo_.filePaths.size()) {
+            return false;
+        }
+        filePath = transferInfo_.filePaths[next];
+        return true;
+    });
+    return protocolHandler.handleConnection() &&
+           protocolHandler.handleReconnection(meInfo.base64Key, meInfo.keyType, false, false);
+}
+
+/**
+ * Uploads all the files over sessionCount concurrent sessions, each one taking the next file from a shared queue
+ * once it is done with the previous one. Logs the aggregate throughput once all the sessions are done.
+ * @param rotateKey Whether to replace the stored key pair with a new one before uploading.
+ * @return True if all the files were successfully sent, false otherwise.
+ */
+bool ParallelUploader::run(bool rotateKey) {
+    MeInfo meInfo;
+    if (!prepareClient(rotateKey, meInfo)) {
+        logger_.error("Failed registering the client, no session was started");
+        return false;
+    }
+
+    uintmax_t totalBytes = 0;
+    for (const std::string& filePath : transferInfo_.filePaths) {
+        std::error_code error;
+        uintmax_t size = std::filesystem::file_size(filePath, error);
+        totalBytes += error ? 0 : size;
+    }
+    unsigned int sessionCount = std::min<size_t>(sessionCount_, transferInfo_.filePaths.size());
+    logger_.info((std::ostringstream() << "Uploading " << transferInfo_.filePaths.size() << " files over "
+                                       << sessionCount << " sessions").str());
+
+    auto start = std::chrono::steady_clock::now();
+    auto workerPool = std::make_shared<ThreadPool>();
+    bool status = true;
+    {
+        ThreadPool sessions(sessionCount);
+        std::vector<std::future<bool>> results;
+        for (unsigned int session = 0; session < sessionCount; ++session) {
+            results.push_back(sessions.submit([this, session, &meInfo, workerPool]() {
+                return runSession(session, meInfo, workerPool);
+            }));
+        }
+        for (auto& result : results) {
+            try {
+                status = result.get() && status;
+            } catch (const std::exception& e) {
+                logger_.error((std::ostringstream() << "Session failed: " << e.what()).str());
+                status = false;
+            }
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    logger_.info((std::ostringstream() << "Uploaded " << totalBytes / 1e6 << " MB in " << elapsed << " s - "
+                                       << (elapsed > 0 ? totalBytes / 1e6 / elapsed : 0) << " MB/s over "
+                                       << sessionCount << " sessions").str());
+    return status;
+}
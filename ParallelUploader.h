@@ -0,0 +1,33 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for ParallelUploader.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_PARALLELUPLOADER_H
+#define DEFENSIVE_MAMAN_15_PARALLELUPLOADER_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include "FileHandler.h"
+#include "Logger.h"
+
+class ThreadPool;
+
+class ParallelUploader {
+public:
+    ParallelUploader(TransferInfo transferInfo, unsigned int sessionCount);
+    bool run(bool rotateKey);
+
+private:
+    TransferInfo transferInfo_;
+    unsigned int sessionCount_;
+    std::atomic<size_t> nextFile_{0};  // The shared queue - an index into transferInfo_.filePaths
+    Logger logger_;
+
+    bool prepareClient(bool rotateKey, MeInfo& meInfo);
+    bool runSession(unsigned int session, const MeInfo& meInfo, std::shared_ptr<ThreadPool> workerPool);
+};
+
+
+#endif
@@ -0,0 +1,86 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Allocate request payloads from a few reused blocks instead of a new heap buffer per request.
+ */
+#include "PayloadArena.h"
+#include <algorithm>
+
+namespace {
+    const size_t ALIGNMENT = 16;
+}
+
+PayloadArena::Scope::Scope(PayloadArena& arena) : arena_(arena), block_(arena.current_), used_(arena.used_) {
+    ++arena_.scopes_;
+}
+
+PayloadArena::Scope::~Scope() {
+    arena_.release(block_, used_);
+}
+
+/**
+ * Allocates an uninitialized buffer, valid until the innermost open Scope ends. A heap allocation happens only when
+ * none of the arena's blocks has room left for it.
+ * @param size The number of bytes to allocate.
+ * @return The allocated buffer.
+ */
+char* PayloadArena::allocate(size_t size) {
+    size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+    for (; current_ < blocks_.size(); ++current_, used_ = 0) {
+        if (blocks_[current_].size - used_ >= size) {
+            char* buffer = blocks_[current_].data.get() + used_;
+            used_ += size;
+            return buffer;
+        }
+    }
+
+    // Blocks are merged once the outermost Scope ends, so there's no need to over-allocate here
+    size_t blockSize = std::max(size, size_t(MIN_BLOCK_SIZE));
+    blocks_.push_back(Block{std::unique_ptr<char[]>(new char[blockSize]), blockSize});
+    ++heapAllocations_;
+    current_ = blocks_.size() - 1;
+    used_ = size;
+    return blocks_[current_].data.get();
+}
+
+/**
+ * Gets the number of heap allocations the arena made since it was created.
+ * @return The number of blocks allocated.
+ */
+size_t PayloadArena::heapAllocations() const {
+    return heapAllocations_;
+}
+
+/**
+ * Gets the number of bytes held by the arena's blocks.
+ * @return The arena's total block size.
+ */
+size_t PayloadArena::capacity() const {
+    size_t total = 0;
+    for (const Block& block : blocks_) {
+        total += block.size;
+    }
+    return total;
+}
+
+/**
+ * Rewinds the arena to a Scope's mark. Once the outermost Scope ends, the blocks are merged into a single block (or
+ * freed, if they're too large to keep), so the next requests are served from one block without growing it again.
+ * @param block The block that was current when the Scope started.
+ * @param used The number of bytes that were used in that block.
+ */
+void PayloadArena::release(size_t block, size_t used) {
+    current_ = block;
+    used_ = used;
+    if (--scopes_ > 0 || (blocks_.size() <= 1 && capacity() <= MAX_RETAINED_SIZE)) {
+        return;
+    }
+    size_t total = capacity();
+    blocks_.clear();
+    if (total <= MAX_RETAINED_SIZE) {
+        blocks_.push_back(Block{std::unique_ptr<char[]>(new char[total]), total});
+        ++heapAllocations_;
+    }
+    current_ = 0;
+    used_ = 0;
+}
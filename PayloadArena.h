@@ -0,0 +1,59 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for PayloadArena.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_PAYLOADARENA_H
+#define DEFENSIVE_MAMAN_15_PAYLOADARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+// A session scoped bump allocator for request payloads. Allocations are released together, when the Scope they were
+// made in ends - so the blocks are allocated once and reused by every following request.
+class PayloadArena {
+public:
+    static const size_t MIN_BLOCK_SIZE = 64 * 1024;
+    // Blocks are kept for reuse as long as they add up to no more than this, so a huge upload doesn't pin its memory
+    static const size_t MAX_RETAINED_SIZE = 64 * 1024 * 1024;
+
+    // Marks the arena on construction, and releases everything allocated since then on destruction
+    class Scope {
+    public:
+        explicit Scope(PayloadArena& arena);
+        ~Scope();
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+
+    private:
+        PayloadArena& arena_;
+        size_t block_;
+        size_t used_;
+    };
+
+    PayloadArena() = default;
+    PayloadArena(const PayloadArena&) = delete;
+    PayloadArena& operator=(const PayloadArena&) = delete;
+
+    char* allocate(size_t size);
+    size_t heapAllocations() const;
+    size_t capacity() const;
+
+private:
+    struct Block {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    void release(size_t block, size_t used);
+
+    std::vector<Block> blocks_;
+    size_t current_ = 0;
+    size_t used_ = 0;
+    size_t scopes_ = 0;
+    size_t heapAllocations_ = 0;
+};
+
+
+#endif
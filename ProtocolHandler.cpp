@@ -5,24 +5,87 @@
  */
 #include "ProtocolHandler.h"
 #include "CryptoHandler.h"
+#include "RSAKeyFactory.h"
 #include "FileHandler.h"
+#include "AESWrapper.h"
+#include "RSAWrapper.h"
+#include "ThreadPool.h"
 #include <cstring>   // For memcpy
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
+#include <sys/stat.h>
 #include <iostream>
 #include "constants.h"
 #include "checksum.h"
+#include "WireFormat.h"
+#include "Base64Wrapper.h"
 #include <system_error>
+#include <cerrno>
+#include <filesystem>
+#include <cstdint>
 #include <utility>
+#include <chrono>
 
 
-ProtocolHandler::ProtocolHandler(std::string  server_address, int port, std::string  name, std::string  filePath)
-        : serverAddress_(std::move(server_address)), port_(port), clientName_(std::move(name)), filePath_(std::move(filePath)), logger_("ProtocolHandler") {}
+ProtocolHandler::ProtocolHandler(std::string  server_address, int port, std::string  name, std::vector<std::string>  filePaths,
+                                 const std::string& loggerName)
+        : serverAddress_(std::move(server_address)), port_(port), clientName_(std::move(name)), filePaths_(std::move(filePaths)), serverVersion_(PROTOCOL_VERSION), logger_(loggerName) {}
 
 ProtocolHandler::~ProtocolHandler() = default;
 
+/**
+ * Makes the session draw the files it sends from a source shared with other sessions, instead of its own file list.
+ * @param fileSource Hands out the next file to send, returning false once there are none left.
+ */
+void ProtocolHandler::setFileSource(FileSource fileSource) {
+    fileSource_ = std::move(fileSource);
+}
+
+/**
+ * Makes the session encrypt on a thread pool shared with other sessions, rather than starting one of its own.
+ * @param workerPool The thread pool to use for CPU heavy work.
+ */
+void ProtocolHandler::shareWorkerPool(std::shared_ptr<ThreadPool> workerPool) {
+    workerPool_ = std::move(workerPool);
+}
+
+/**
+ * Gets the number of heap allocations the session's payload arena made so far - the arena reuses its blocks, so this
+ * only grows when a payload outgrows every earlier one.
+ * @return The number of heap allocations made for request payloads.
+ */
+size_t ProtocolHandler::payloadHeapAllocations() const {
+    return payloadArena_.heapAllocations();
+}
+
+/**
+ * Gets the session's AES cipher context, creating it only when the key differs from the one it was built for - so
+ * the key schedule and mode objects are reused by every file sent during the session.
+ * @param aes_key The AES key received from the server.
+ * @return The cipher context bound to the key.
+ */
+AESWrapper& ProtocolHandler::sessionCipher(const std::string& aes_key) {
+    if (!sessionCipher_ || aes_key.size() != AESWrapper::DEFAULT_KEYLENGTH ||
+        std::memcmp(sessionCipher_->getKey(), aes_key.data(), AESWrapper::DEFAULT_KEYLENGTH) != 0) {
+        sessionCipher_ = CryptoHandler::create_aes_cipher(aes_key);
+    }
+    return *sessionCipher_;
+}
+
+/**
+ * Gets the thread pool used for CPU heavy work such as parallel segment encryption, starting it on first use.
+ * @return The handler's thread pool.
+ */
+ThreadPool& ProtocolHandler::workerPool() {
+    if (!workerPool_) {
+        workerPool_ = std::make_shared<ThreadPool>();
+    }
+    return *workerPool_;
+}
+
 /**
  * Establishes a connection to the server.
  * @return True if the connection is successful, false otherwise.
@@ -49,33 +112,71 @@ bool ProtocolHandler::handleConnection() {
 
 /**
  * Sends a request object to the server. If we were unable to send the message - throwing / logging the error.
+ * The header and the payload are handed to the socket as separate buffers, so the payload is never copied.
  * @param request The request object to send.
  */
 void ProtocolHandler::sendRequest(const Request& request) {
-    // Calculate the total size of the buffer
-    size_t totalSize = sizeof(Request) - sizeof(request.payload) + request.payloadSize;
-
-    // Allocate buffer
-    char* buffer = new char[totalSize];
-
-    // Copy fixed-size portion of the Request (excluding the payload pointer)
-    std::memcpy(buffer, &request, sizeof(Request) - sizeof(request.payload));
-
-    // Copy the variable-length payload
-    std::memcpy(buffer + sizeof(Request) - sizeof(request.payload), request.payload, request.payloadSize);
+    using namespace WireFormat;
+    iovec parts[2];
+
+    // The fixed-size header, encoded field by field
+    char header[RequestHeader::SIZE];
+    RequestHeader::ClientId::store(header, request.clientId);
+    RequestHeader::Version::store(header, static_cast<uint8_t>(request.version));
+    RequestHeader::Code::store(header, request.code);
+    RequestHeader::PayloadSize::store(header, request.payloadSize);
+    parts[0].iov_base = header;
+    parts[0].iov_len = sizeof(header);
+
+    // The variable-length payload
+    parts[1].iov_base = request.payload;
+    parts[1].iov_len = request.payloadSize;
 
     // Sending the request to the server:
     try {
-        if (send(socket_, buffer, totalSize, 0) == -1) {
-            // Throwing a custom error:
-            throw std::system_error(errno, std::system_category(), "Failed to send message to server");
-        }
+        sendParts(parts, 2);
     } catch (const std::exception& e) {
         logger_.error((std::ostringstream() << "Exception caught in sendRequest: " << e.what()).str());
     }
+}
+
+/**
+ * Sends a sequence of buffers to the server as one contiguous message, resuming after partial sends until every
+ * byte was sent.
+ * @param parts The buffers to send, in order - advanced in place as they are sent.
+ * @param count The number of buffers.
+ * @throws std::system_error If the socket fails.
+ */
+void ProtocolHandler::sendParts(iovec* parts, size_t count) {
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;  // Report a closed connection as EPIPE instead of raising SIGPIPE
+#else
+    const int flags = 0;
+#endif
+    msghdr message{};
+    message.msg_iov = parts;
+    message.msg_iovlen = count;
+    while (message.msg_iovlen > 0) {
+        ssize_t sent = sendmsg(socket_, &message, flags);
+        if (sent == -1) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category(), "Failed to send message to server");
+        }
 
-    // Clean up
-    delete[] buffer;
+        // Skip the buffers that were sent in full, and the sent prefix of the one that wasn't
+        auto remaining = static_cast<size_t>(sent);
+        while (message.msg_iovlen > 0 && remaining >= message.msg_iov->iov_len) {
+            remaining -= message.msg_iov->iov_len;
+            ++message.msg_iov;
+            --message.msg_iovlen;
+        }
+        if (message.msg_iovlen > 0) {
+            message.msg_iov->iov_base = static_cast<char*>(message.msg_iov->iov_base) + remaining;
+            message.msg_iov->iov_len -= remaining;
+        }
+    }
 }
 
 /**
@@ -89,7 +190,9 @@ void ProtocolHandler::sendRequest(const Request& request) {
 ssize_t ProtocolHandler::safeReceive(int socket, void *buffer, size_t length, int flags) {
     ssize_t bytes_received;
     try {
-        bytes_received = recv(socket, buffer, length, flags);
+        do {
+            bytes_received = recv(socket, buffer, length, flags);
+        } while (bytes_received == -1 && errno == EINTR);
         if (bytes_received == -1) {
             // Handle error
             throw std::system_error(errno, std::system_category(), "recv failed");
@@ -103,40 +206,57 @@ ssize_t ProtocolHandler::safeReceive(int socket, void *buffer, size_t length, in
 }
 
 /**
- * Receives and deserializes a response from the server into a Response object.
+ * Receives exactly the requested number of bytes, calling recv as many times as short reads require.
+ * @param buffer The buffer to receive the data into.
+ * @param length The number of bytes to receive.
+ * @return The number of bytes received - less than length only if the connection was closed or failed.
+ */
+size_t ProtocolHandler::receiveExactly(char* buffer, size_t length) {
+    size_t received = 0;
+    while (received < length) {
+        ssize_t bytes_received = safeReceive(socket_, buffer + received, length - received, 0);
+        if (bytes_received <= 0) {
+            break;  // Connection closed, or an error that was already reported
+        }
+        received += static_cast<size_t>(bytes_received);
+    }
+    return received;
+}
+
+/**
+ * Receives and deserializes a response from the server into a Response object. The payload is received into a buffer
+ * kept by the handler and reused by every response, so it is only valid until the next call.
  * @return The deserialized response object.
  */
 Response ProtocolHandler::getResponse() {
-    Response response;
+    using namespace WireFormat;
+    Response response{};
 
     // Receive the fixed-size part of the response
-    char header_buffer[1 + 2 + 4];  // version (1 byte) + code (2 bytes) + payloadSize (4 bytes)
-    ssize_t bytes_received = safeReceive(socket_, header_buffer, sizeof(header_buffer), 0);
+    char header_buffer[ResponseHeader::SIZE];  // version (1 byte) + code (2 bytes) + payloadSize (4 bytes)
+    size_t bytes_received = receiveExactly(header_buffer, sizeof(header_buffer));
     if (bytes_received != sizeof(header_buffer)) {
         logger_.serverError((std::ostringstream() << "Received partial headers data, expected " << sizeof(header_buffer) << "bytes, got " << bytes_received).str());
         return response;
     }
 
     // Deserialize the fixed-size part
-    size_t offset = 0;
-    response.version = char(header_buffer[offset] + '0');  // Convert to ascii value.
-    offset += 1;
-
-    response.code = ntohs(*reinterpret_cast<uint16_t*>(header_buffer + offset));
-    offset += 2;
-
-    response.payloadSize = ntohl(*reinterpret_cast<uint32_t*>(header_buffer + offset));
-
-    // Receive the payload based on the payloadSize
-    char payload_buffer[response.payloadSize];
-    bytes_received = safeReceive(socket_, payload_buffer, response.payloadSize, 0);
+    response.version = char(ResponseHeader::Version::load(header_buffer) + '0');  // Convert to ascii value.
+    serverVersion_ = response.version;
+    response.code = ResponseHeader::Code::load(header_buffer);
+    response.payloadSize = ResponseHeader::PayloadSize::load(header_buffer);
+
+    // Receive the payload based on the payloadSize, growing the receive buffer only if it's too small
+    if (receiveBuffer_.size() < response.payloadSize) {
+        receiveBuffer_.resize(response.payloadSize);
+    }
+    bytes_received = receiveExactly(receiveBuffer_.data(), response.payloadSize);
     if (bytes_received != response.payloadSize) {
         logger_.serverError((std::ostringstream() << "Received partial payload, expected " << response.payloadSize << "bytes, got " << bytes_received).str());
         return response;
     }
 
-    // Convert the payload buffer to a std::string
-    response.payload = std::string(payload_buffer, response.payloadSize);
+    response.payload = std::string_view(receiveBuffer_.data(), response.payloadSize);
     return response;
 }
 
@@ -153,14 +273,14 @@ bool ProtocolHandler::sendCRCStatusRequest(char *clientId, uint16_t code) {
     file_request.version = PROTOCOL_VERSION;
     file_request.code = code;
 
-    char* payload_buffer = new char[filePath_.length() + 1];
+    PayloadArena::Scope scope(payloadArena_);
+    char* payload_buffer = payloadArena_.allocate(filePath_.length() + 1);
     std::strcpy(payload_buffer, filePath_.c_str());
     file_request.payloadSize = filePath_.length() + 1;
     file_request.payload = payload_buffer;
 
     // Send the request and get the response
     sendRequest(file_request);
-    delete[] file_request.payload;
     Response file_response = getResponse();
     return file_response.code == ServerResponses::CONFIRM_MSG;
 }
@@ -171,24 +291,53 @@ bool ProtocolHandler::sendCRCStatusRequest(char *clientId, uint16_t code) {
  * @param encrypted_content The request containing encrypted content to send.
  * @param maxRetries The maximum number of retries allowed.
  * @param clientId The client's identifier.
+ * @param fileCrc The CRC of the file's plaintext, calculated while it was read for encryption.
+ * @return True if the file was successfully sent and verified, false otherwise.
+ */
+bool ProtocolHandler::handleRetrySendFile(const Request& encrypted_content, int maxRetries, char *clientId, uint32_t fileCrc) {
+    bool concluded = false;
+    return handleRetryUpload([this, &encrypted_content, fileCrc](uint32_t& uploadCrc) {
+        sendRequest(encrypted_content);
+        uploadCrc = fileCrc;
+        return getResponse();
+    }, maxRetries, clientId, concluded);
+}
+
+/**
+ * Runs an upload and the CRC check that follows it, repeating the upload up to maxRetries times while the CRC the
+ * server calculated doesn't match ours. Gives up at once if no response arrives - there's no point in resending over
+ * a broken connection, nor in telling the server the upload is done.
+ * @param upload Sends the file and returns the server's response, storing the CRC of the file it sent. Returns an
+ * empty response (code 0) if the upload can't go on.
+ * @param maxRetries The maximum number of retries allowed.
+ * @param clientId The client's identifier.
+ * @param concluded Set to whether the server confirmed the upload's conclusion - CRC_CORRECT or CRC_INCORRECT_DONE.
  * @return True if the file was successfully sent and verified, false otherwise.
  */
-bool ProtocolHandler::handleRetrySendFile(const Request& encrypted_content, int maxRetries, char *clientId) {
+bool ProtocolHandler::handleRetryUpload(const std::function<Response(uint32_t&)>& upload, int maxRetries, char *clientId,
+                                        bool& concluded) {
     int retry_count = 0;
     bool status = false;
+    concluded = false;
     while (retry_count < maxRetries) {
-        sendRequest(encrypted_content);
-        Response response = getResponse();
+        uint32_t fileCrc = 0;
+        Response response = upload(fileCrc);
+        if (response.code == 0) {
+            logger_.serverError("upload was interrupted, giving up on the file");
+            return false;
+        }
         if (response.code == ServerResponses::FILE_RECEIVED_CRC_OK) {
             // Extract last 4 bytes that represent the CRC:
-            uint32_t receivedCRC = *reinterpret_cast<uint32_t*>(&response.payload[response.payload.size() - 4]);
-            uint32_t calculatedCRC = readCrc(filePath_);
-
-            if (receivedCRC == calculatedCRC) {
+            uint32_t receivedCRC = 0;
+            if (response.payload.size() >= 4) {
+                std::memcpy(&receivedCRC, response.payload.data() + response.payload.size() - 4, 4);
+            }
+            if (receivedCRC == fileCrc) {
                 logger_.info("CRC Match, Responding with CRC Correct status to server");
                 if (sendCRCStatusRequest(clientId, ServerRequests::Codes::CRC_CORRECT)) {
                     logger_.info("Successfully finished Client's file sending flow");
                     status = true;
+                    concluded = true;
                 } else {
                     logger_.serverError("Failed to finish Client's file sending flow - server didn't accept message.");
                 }
@@ -204,32 +353,30 @@ bool ProtocolHandler::handleRetrySendFile(const Request& encrypted_content, int
     // If after max_retries we didn't get a successful response, send a failure request with CRC_INCORRECT_DONE code:
     if (retry_count == maxRetries) {
         logger_.serverError("reached max retries but wasn't able to successfully upload file to server");
-        sendCRCStatusRequest(clientId, ServerRequests::Codes::CRC_INCORRECT_DONE);
+        concluded = sendCRCStatusRequest(clientId, ServerRequests::Codes::CRC_INCORRECT_DONE);
     }
     return status;
 }
 
 /**
- * Creates a payload buffer for file content that we can utilize when attempting to send a request to the server.
+ * Creates a payload buffer for file content that we can utilize when attempting to send a request to the server. The
+ * content size and file name fields are filled in, the content itself is left for the caller to write in place.
+ * @param arena The arena to allocate the payload buffer from.
  * @param fileName The name of the file.
- * @param content The content of the file.
- * @return A pointer to the dynamically allocated payload buffer.
+ * @param contentSize The size of the content in bytes.
+ * @return A pointer to the payload buffer, valid until the arena's current scope ends.
  */
-char* createFilePayloadBuffer(const std::string& fileName, const std::string& content) {
-    size_t totalPayloadSize = 4 + 255 + content.size();  // 4 for content size, 255 for file name
-    char* buffer = new char[totalPayloadSize + 1];
-    std::memset(buffer, 0, totalPayloadSize);
+char* createFilePayloadBuffer(PayloadArena& arena, const std::string& fileName, size_t contentSize) {
+    char* buffer = arena.allocate(4 + 255 + contentSize);  // 4 for content size, 255 for file name
+    std::memset(buffer, 0, 4 + 255);
 
     // Convert contentSize to big-endian (network byte order)
-    uint32_t contentSizeNetworkOrder = htonl(content.size());
+    uint32_t contentSizeNetworkOrder = htonl(contentSize);
     std::memcpy(buffer, &contentSizeNetworkOrder, 4);
 
     // Set file name, assuming fileName won't exceed 255 chars due to previous validations:
     std::strncpy(buffer + 4, fileName.c_str(), 255);
 
-    // Set content
-    strcpy(buffer + 4 + 255, content.data());
-
     return buffer;
 }
 
@@ -241,21 +388,23 @@ char* createFilePayloadBuffer(const std::string& fileName, const std::string& co
  */
 Response ProtocolHandler::handleConnectionRequest(char *clientId, uint16_t requestCode) {
     Request request {};
-    std::vector<char> payload_buffer(ServerRequests::Consts::NAME_FIELD_SIZE, 0);
+    PayloadArena::Scope scope(payloadArena_);
+    char* payload_buffer = payloadArena_.allocate(ServerRequests::Consts::NAME_FIELD_SIZE);
+    std::memset(payload_buffer, 0, ServerRequests::Consts::NAME_FIELD_SIZE);
     // Initializing a default "empty" clientId:
     std::memset(request.clientId, 0, sizeof(request.clientId));
     // Defining the request attributes:
     request.version = PROTOCOL_VERSION;
     request.code = requestCode;
-    std::strncpy(payload_buffer.data(), clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
+    std::strncpy(payload_buffer, clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
     request.payloadSize = ServerRequests::Consts::NAME_FIELD_SIZE;
-    request.payload = payload_buffer.data();
+    request.payload = payload_buffer;
 
     // Performing a request:
     sendRequest(request);
     Response serverResponse = getResponse();
     // Store the received ClientId and return the response:
-    memcpy(clientId, serverResponse.payload.c_str(), std::min<size_t>(16, serverResponse.payload.size()));
+    memcpy(clientId, serverResponse.payload.data(), std::min<size_t>(16, serverResponse.payload.size()));
     return serverResponse;
 }
 
@@ -266,24 +415,69 @@ Response ProtocolHandler::handleConnectionRequest(char *clientId, uint16_t reque
  * @return The response from the server.
  */
 Response ProtocolHandler::handleRSARegistration(char* clientId, std::string& outPrivateKey) {
-    CryptoHandler crypto;
+    // Take the next RSA pair generated in the background
+    auto [publicKey, privateKey] = RSAKeyFactory::shared().take();
+    outPrivateKey = privateKey;
+    return sendPublicKey(clientId, ServerRequests::Codes::SEND_PUBLIC_KEY, PROTOCOL_VERSION, publicKey, privateKey,
+                         KeyType::RSA);
+}
+
+/**
+ * Handles the X25519 registration process with the server - the X25519 counterpart of handleRSARegistration.
+ * @param clientId The client's identifier.
+ * @param outPrivateKey The private key generated will be stored here.
+ * @return The response from the server.
+ */
+Response ProtocolHandler::handleX25519Registration(char* clientId, std::string& outPrivateKey) {
+    auto [publicKey, privateKey] = CryptoHandler::generate_x25519_key_pair();
+    outPrivateKey = privateKey;
+    return sendPublicKey(clientId, ServerRequests::Codes::SEND_X25519_PUBLIC_KEY, X25519_KEY_EXCHANGE_PROTOCOL_VERSION,
+                         publicKey, privateKey, KeyType::X25519);
+}
+
+/**
+ * Registers a new key pair with the server, using X25519 if the server supports it and RSA otherwise.
+ * @param clientId The client's identifier.
+ * @param outPrivateKey The private key generated will be stored here.
+ * @param outKeyType The type of the private key generated will be stored here.
+ * @return The response from the server.
+ */
+Response ProtocolHandler::handleKeyRegistration(char* clientId, std::string& outPrivateKey, KeyType& outKeyType) {
+    if (serverVersion_ >= X25519_KEY_EXCHANGE_PROTOCOL_VERSION) {
+        outKeyType = KeyType::X25519;
+        return handleX25519Registration(clientId, outPrivateKey);
+    }
+    outKeyType = KeyType::RSA;
+    return handleRSARegistration(clientId, outPrivateKey);
+}
+
+/**
+ * Persists a newly generated key pair and sends its public key to the server.
+ * @param clientId The client's identifier.
+ * @param code The request code matching the key's type.
+ * @param version The request version matching the key's type.
+ * @param publicKey The public key to send.
+ * @param privateKey The private key to persist.
+ * @param keyType The type of the private key, persisted with it.
+ * @return The response from the server.
+ */
+Response ProtocolHandler::sendPublicKey(char* clientId, uint16_t code, char version, const std::string& publicKey,
+                                        const std::string& privateKey, KeyType keyType) {
     FileHandler fileHandler;
+    PayloadArena::Scope scope(payloadArena_);
     Response serverResponse;
     char* payload_buffer;
 
-    // Generate RSA keys
-    auto [publicKey, privateKey] = CryptoHandler::generate_rsa_key_pair();
-
     Request pubkey_request{};
     memcpy(pubkey_request.clientId, clientId, 16);
-    pubkey_request.version = PROTOCOL_VERSION;
-    pubkey_request.code = ServerRequests::Codes::SEND_PUBLIC_KEY;
+    pubkey_request.version = version;
+    pubkey_request.code = code;
 
     // Calculate total payload size
     size_t totalPayloadSize = ServerRequests::Consts::NAME_FIELD_SIZE + publicKey.size();
 
-    // Allocate memory dynamically for the combined payload
-    payload_buffer = new char[totalPayloadSize];
+    // Allocate memory from the session's arena for the combined payload
+    payload_buffer = payloadArena_.allocate(totalPayloadSize);
 
     // Initialize the buffer with zeros
     std::memset(payload_buffer, 0, totalPayloadSize);
@@ -291,62 +485,424 @@ Response ProtocolHandler::handleRSARegistration(char* clientId, std::string& out
     // Copy the client name into the buffer
     std::strncpy(payload_buffer, clientName_.c_str(), ServerRequests::Consts::NAME_FIELD_SIZE - 1);
 
-    // Append the public key to the buffer
-    std::strncpy(payload_buffer + ServerRequests::Consts::NAME_FIELD_SIZE, publicKey.c_str(), publicKey.size());
+    // Append the public key to the buffer (raw X25519 keys may contain zero bytes, so copy it as is)
+    std::memcpy(payload_buffer + ServerRequests::Consts::NAME_FIELD_SIZE, publicKey.data(), publicKey.size());
 
     pubkey_request.payloadSize = totalPayloadSize;
     pubkey_request.payload = payload_buffer;
 
     // Save the private key + me.info:
-    fileHandler.savePrivateRSAKey(privateKey);
-    fileHandler.saveMeInfo(clientName_, pubkey_request.clientId, privateKey);
+    fileHandler.savePrivateKey(privateKey, keyType);
+    fileHandler.saveMeInfo(clientName_, pubkey_request.clientId, privateKey, keyType);
 
     // Performing a request, sending the public key to the server:
     sendRequest(pubkey_request);
-    delete[] payload_buffer;
     serverResponse = getResponse();
-
-    // Save the private key to the output reference
-    outPrivateKey = privateKey;
     return serverResponse;
 }
 
+/**
+ * Decrypts the AES key sent by the server, using the client's private key - RSA or X25519, as its type tells.
+ * @param encrypted_aes_key The AES key received from the server.
+ * @param keyType The type of the client's private key.
+ * @param privateKey The client's private key.
+ * @return The AES key.
+ */
+std::string ProtocolHandler::decryptAesKey(const std::string& encrypted_aes_key, KeyType keyType,
+                                           const std::string& privateKey) {
+    std::string aes_key = CryptoHandler::decrypt_aes_key(encrypted_aes_key, keyType, privateKey, rsaDecryptor_);
+    wrappedSessionKey_ = encrypted_aes_key;
+    identityKey_ = privateKey;
+    identityKeyType_ = keyType;
+    return aes_key;
+}
+
 /**
  * Handles the encryption and sending of a file to the server.
  * @param encrypted_aes_key The AES key received from the server.
- * @param privateKey The RSA private key for decryption.
+ * @param keyType The type of the client's private key.
+ * @param privateKey The client's private key (RSA or X25519) for decryption.
  * @param clientId The client's identifier.
  * @return True if the file is successfully encrypted and sent, false otherwise.
  */
-bool ProtocolHandler::handleFileEncryptionAndSend(const std::string& encrypted_aes_key, const std::string& privateKey, const char* clientId) {
-    CryptoHandler crypto;
-    FileHandler fileHandler;
+bool ProtocolHandler::handleFileEncryptionAndSend(const std::string& encrypted_aes_key, KeyType keyType,
+                                                  const std::string& privateKey, const char* clientId) {
+    // Decrypt received AES key using the private key - skip first 16 bytes of Client ID:
+    std::string aes_key = decryptAesKey(encrypted_aes_key, keyType, privateKey);
+    return sendFiles(aes_key, clientId);
+}
 
-    // Decrypt received AES key using the RSA private key - skip first 16 bytes of Client ID:
-    std::string aes_key = CryptoHandler::decrypt_with_rsa(encrypted_aes_key, privateKey);
+/**
+ * Sends every file of the session over the current connection, each through its own SEND_FILE and CRC round, using
+ * the AES key negotiated once for the whole session. A file that fails doesn't stop the ones after it.
+ * @param aes_key The plain AES key shared with the server.
+ * @param clientId The client's identifier.
+ * @return True if all the files were successfully encrypted and sent, false otherwise.
+ */
+bool ProtocolHandler::sendFiles(const std::string& aes_key, const char* clientId) {
+    size_t next = 0;
+    FileSource nextFile = fileSource_ ? fileSource_ : [this, &next](std::string& filePath) {
+        if (next == filePaths_.size()) {
+            return false;
+        }
+        filePath = filePaths_[next++];
+        return true;
+    };
+
+    size_t attempted = 0, sent = 0;
+    while (nextFile(filePath_)) {
+        attempted++;
+        logger_.info((std::ostringstream() << "Sending " << filePath_).str());
+        std::error_code error;
+        if (!std::filesystem::is_regular_file(filePath_, error)) {
+            logger_.error((std::ostringstream() << "Skipping " << filePath_ << " - no such file").str());
+        } else if (sendEncryptedFile(aes_key, clientId)) {
+            sent++;
+        } else {
+            logger_.error((std::ostringstream() << "Failed sending " << filePath_).str());
+        }
+    }
+    logger_.info((std::ostringstream() << "Sent " << sent << " of " << attempted
+                                       << " files over a single session").str());
+    return sent == attempted;
+}
 
-    // Read the file's contents
-    std::string fileContents = fileHandler.readFileContents(filePath_);
+/**
+ * Encrypts the file using an already decrypted AES key and sends it to the server.
+ * @param aes_key The plain AES key shared with the server.
+ * @param clientId The client's identifier.
+ * @return True if the file is successfully encrypted and sent, false otherwise.
+ */
+bool ProtocolHandler::sendEncryptedFile(const std::string& aes_key, const char* clientId) {
+    FileHandler fileHandler;
 
-    // Encrypt the file content using AES key
-    std::string encrypted_content = CryptoHandler::encrypt_with_aes(fileContents, aes_key);
+    // Pick the richest content encoding the server advertised - parallel AES-GCM segments, raw AES-CBC cipher text,
+    // or hex encoded AES-CBC cipher text for servers speaking the original protocol version:
+    ContentEncoding encoding = ContentEncoding::HEX;
+    char requestVersion = PROTOCOL_VERSION;
+    if (serverVersion_ >= SEGMENTED_GCM_PROTOCOL_VERSION) {
+        encoding = ContentEncoding::SEGMENTED_GCM;
+        requestVersion = SEGMENTED_GCM_PROTOCOL_VERSION;
+    } else if (serverVersion_ >= BINARY_CONTENT_PROTOCOL_VERSION) {
+        encoding = ContentEncoding::BINARY;
+        requestVersion = BINARY_CONTENT_PROTOCOL_VERSION;
+    }
 
-    // Create the payload buffer
-    char* payloadBuffer = createFilePayloadBuffer(filePath_, encrypted_content);
+    // Size the payload up front, so the encrypted content can be written straight into it
+    std::ifstream fileStream = fileHandler.openFileForReading(filePath_);
+    size_t fileSize = std::filesystem::file_size(filePath_);
+    if (serverVersion_ >= CHUNKED_UPLOAD_PROTOCOL_VERSION && fileSize >= CHUNKED_UPLOAD_MIN_FILE_SIZE) {
+        return sendFileInChunks(aes_key, clientId, fileStream, fileSize);
+    }
+    size_t contentSize = CryptoHandler::encrypted_content_size(fileSize, encoding);
+    if (contentSize > UINT32_MAX - 4 - 255) {
+        logger_.error("File is too large to be sent in a single request");
+        return false;
+    }
+    PayloadArena::Scope scope(payloadArena_);
+    size_t heapAllocations = payloadArena_.heapAllocations();
+    char* payloadBuffer = createFilePayloadBuffer(payloadArena_, filePath_, contentSize);
+
+    // Read the file once, encrypting it using the AES key and calculating its CRC in the same pass
+    uint32_t fileCrc = 0;
+    size_t written = 0;
+    char* content = payloadBuffer + 4 + 255;
+    try {
+        if (encoding == ContentEncoding::SEGMENTED_GCM) {
+            written = CryptoHandler::encrypt_stream_with_aes_gcm(fileStream, fileSize, sessionCipher(aes_key), workerPool(), segmentBuffers_, content, contentSize, fileCrc);
+        } else {
+            written = CryptoHandler::encrypt_stream_with_aes(fileStream, sessionCipher(aes_key), encoding, content, contentSize, fileCrc);
+        }
+    } catch (const std::length_error&) {
+        written = SIZE_MAX;  // The file grew past the size the payload was allocated for
+    } catch (const std::runtime_error& e) {
+        logger_.error((std::ostringstream() << "Failed encrypting file: " << e.what()).str());
+        written = SIZE_MAX;
+    }
+    fileStream.close();
+    if (written != contentSize) {
+        logger_.error("File changed or could not be read while it was being encrypted");
+        return false;
+    }
 
     // Set up the request object
     Request encrypted_file_request{};
     memcpy(encrypted_file_request.clientId, clientId, 16);
-    encrypted_file_request.version = PROTOCOL_VERSION;
+    encrypted_file_request.version = requestVersion;
     encrypted_file_request.code = ServerRequests::Codes::SEND_FILE;  // Sending a file request code
-    encrypted_file_request.payloadSize = 4 + 255 + encrypted_content.size();  // 4 for content size, 255 for file name, rest for content
+    encrypted_file_request.payloadSize = 4 + 255 + contentSize;  // 4 for content size, 255 for file name, rest for content
     encrypted_file_request.payload = payloadBuffer;
 
     // Attempting to perform the request up to 3 times:
-    bool status = ProtocolHandler::handleRetrySendFile(encrypted_file_request, 3, (char *)clientId);
+    bool status = ProtocolHandler::handleRetrySendFile(encrypted_file_request, 3, (char *)clientId, fileCrc);
+    logger_.info((std::ostringstream() << "Upload made " << payloadArena_.heapAllocations() - heapAllocations
+                                       << " payload heap allocations").str());
+    return status;
+}
+
+/**
+ * Records the version of a file an upload journal is kept for: its modification time, inode and change time.
+ * @param path The file's path.
+ * @param journal The journal to record the version in.
+ * @throws std::system_error If the file can't be examined.
+ */
+void recordFileVersion(const std::string& path, UploadJournal& journal) {
+    struct stat status{};
+    if (stat(path.c_str(), &status) != 0) {
+        throw std::system_error(errno, std::generic_category(), "Unable to examine " + path);
+    }
+#ifdef __APPLE__
+    const timespec& changed = status.st_ctimespec;
+#else
+    const timespec& changed = status.st_ctim;
+#endif
+    journal.fileModified = static_cast<int64_t>(std::filesystem::last_write_time(path).time_since_epoch().count());
+    journal.fileInode = static_cast<uint64_t>(status.st_ino);
+    journal.fileChanged = static_cast<int64_t>(changed.tv_sec) * 1000000000 + changed.tv_nsec;
+}
+
+/**
+ * Checks the part of a file an upload journal acknowledges still holds what was sent, by reading it again through
+ * the CRC and comparing the result to the journal's running CRC state.
+ * @param fileStream The opened file, left at an unspecified position.
+ * @param journal The journal to check against.
+ * @return True if the acknowledged plaintext is unchanged, false otherwise.
+ */
+bool acknowledgedPrefixMatches(std::istream& fileStream, const UploadJournal& journal) {
+    std::vector<char> block(CRC_READ_CHUNK_SIZE);
+    CrcState crc = crcInit();
+    fileStream.clear();
+    fileStream.seekg(0);
+    while (crc.length < journal.crcLength) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(block.size(), journal.crcLength - crc.length));
+        if (!fileStream.read(block.data(), static_cast<std::streamsize>(length))) {
+            return false;
+        }
+        crcUpdate(crc, block.data(), length);
+    }
+    return crc.crc == journal.crc;
+}
+
+/**
+ * Looks for a journal left by an interrupted multi-part upload of the same, unchanged file, and asks the server
+ * whether it still holds the content the journal acknowledges. The file must be the same version - size, modification
+ * time, inode and change time - and its acknowledged part must still match the journal's CRC: resuming a changed file
+ * would both corrupt the upload and reuse the nonces of its unacknowledged segments on different plaintext.
+ * @param fileHandler The file handler to read the journal with.
+ * @param fileStream The opened file, left at an unspecified position.
+ * @param request A request with the client's id filled in.
+ * @param payload A buffer with the upload's file name filled in, at least UploadPayload::SIZE bytes long.
+ * @param contentSize The size of the encrypted content.
+ * @param journal The journal to resume from will be stored here.
+ * @param aes_key The AES key the interrupted upload was encrypted with will be stored here.
+ * @return True if the upload can be resumed from the journal, false if it has to start over.
+ */
+bool ProtocolHandler::resumeUpload(FileHandler& fileHandler, std::istream& fileStream, Request& request, char* payload,
+                                   size_t contentSize, UploadJournal& journal, std::string& aes_key) {
+    using namespace WireFormat;
+    size_t fileSize = std::filesystem::file_size(filePath_);
+    size_t segments = CryptoHandler::gcm_segment_count(fileSize);
+    if (!fileHandler.readUploadJournal(filePath_, journal)) {
+        return false;
+    }
+    UploadJournal current{};
+    recordFileVersion(filePath_, current);
+    size_t expectedOffset = GCM_CONTENT_HEADER_SIZE + journal.nextSegment * (GCM_SEGMENT_SIZE + AESWrapper::GCM_TAG_LENGTH);
+    if (journal.fileSize != fileSize || journal.fileModified != current.fileModified ||
+        journal.fileInode != current.fileInode || journal.fileChanged != current.fileChanged ||
+        journal.clientId != std::string(request.clientId, 16) || journal.nextSegment == 0 ||
+        journal.nextSegment > segments || journal.offset != std::min(expectedOffset, contentSize) ||
+        journal.crcLength != std::min<uint64_t>(journal.nextSegment * GCM_SEGMENT_SIZE, fileSize) ||
+        journal.contentHeader.size() != GCM_CONTENT_HEADER_SIZE) {
+        logger_.info("Found an upload journal that doesn't match the file, starting the upload over");
+        return false;
+    }
+    if (!acknowledgedPrefixMatches(fileStream, journal)) {
+        logger_.info("The file's acknowledged content changed since the upload was interrupted, starting it over");
+        return false;
+    }
+    try {
+        aes_key = decryptAesKey(journal.wrappedAesKey, identityKeyType_, identityKey_);
+    } catch (const std::exception& e) {
+        logger_.warning((std::ostringstream() << "Unable to recover the interrupted upload's key: " << e.what()).str());
+        return false;
+    }
+
+    UploadPayload::ContentSize::store(payload, contentSize);
+    request.code = ServerRequests::Codes::RESUME_FILE_UPLOAD;
+    request.payloadSize = UploadPayload::SIZE;
+    request.payload = payload;
+    sendRequest(request);
+    Response response = getResponse();
+    if (response.code != ServerResponses::CONFIRM_MSG || response.payload.size() < UploadProgress::SIZE ||
+        UploadProgress::ReceivedSize::load(response.payload.data()) < journal.offset) {
+        logger_.info("Server can't resume the interrupted upload, starting it over");
+        return false;
+    }
+    logger_.info((std::ostringstream() << "Resuming the upload from " << journal.offset << " of " << contentSize
+                                       << " bytes").str());
+    return true;
+}
+
+/**
+ * Sends a file as a multi-part upload: BEGIN_FILE_UPLOAD announces the total size of the encrypted content, which is
+ * then streamed as SEND_FILE_CHUNK requests of UPLOAD_CHUNK_SEGMENTS SEGMENTED_GCM segments each, and
+ * COMMIT_FILE_UPLOAD asks the server to verify it. Only a single chunk is held in memory at a time, and the content
+ * size isn't limited by the 32-bit request payload size.
+ * Each chunk is acknowledged by the server, one chunk behind the one being sent, and every acknowledgement is
+ * checkpointed to an upload journal. If the upload is interrupted, the next run continues it from the last
+ * acknowledged chunk (see resumeUpload), under the AES key it was started with.
+ * @param aes_key The plain AES key shared with the server.
+ * @param clientId The client's identifier.
+ * @param fileStream The opened file.
+ * @param fileSize The file's size in bytes.
+ * @return True if the file is successfully encrypted and sent, false otherwise.
+ */
+bool ProtocolHandler::sendFileInChunks(const std::string& aes_key, const char* clientId, std::ifstream& fileStream,
+                                       size_t fileSize) {
+    using namespace WireFormat;
+    FileHandler fileHandler;
+    size_t contentSize = CryptoHandler::encrypted_content_size(fileSize, ContentEncoding::SEGMENTED_GCM);
+    size_t segments = CryptoHandler::gcm_segment_count(fileSize);
+
+    Request request{};
+    memcpy(request.clientId, clientId, 16);
+    request.version = CHUNKED_UPLOAD_PROTOCOL_VERSION;
+
+    PayloadArena::Scope scope(payloadArena_);
+    size_t heapAllocations = payloadArena_.heapAllocations();
+    char* chunk = payloadArena_.allocate(UploadPayload::SIZE + GCM_CONTENT_HEADER_SIZE +
+                                         UPLOAD_CHUNK_SEGMENTS * (GCM_SEGMENT_SIZE + AESWrapper::GCM_TAG_LENGTH));
+    char fileName[UploadPayload::FileName::SIZE] = {};
+    std::strncpy(fileName, filePath_.c_str(), sizeof(fileName));
+    UploadPayload::FileName::store(chunk, fileName);
+
+    // Only the first attempt may resume - a retry follows a CRC mismatch, so the content has to be sent anew
+    UploadJournal journal;
+    std::string uploadKey;
+    bool resume = resumeUpload(fileHandler, fileStream, request, chunk, contentSize, journal, uploadKey);
+    auto checkpoint = [&]() {
+        try {
+            fileHandler.saveUploadJournal(journal);
+        } catch (const std::runtime_error& e) {
+            logger_.warning((std::ostringstream() << "Failed saving the upload journal: " << e.what()).str());
+        }
+    };
+
+    bool concluded = false;
+    bool status = handleRetryUpload([&](uint32_t& uploadCrc) {
+        Response response{};
+        char header[GCM_CONTENT_HEADER_SIZE];
+        if (resume) {
+            std::memcpy(header, journal.contentHeader.data(), sizeof(header));
+        } else {
+            // Announce the upload:
+            UploadPayload::ContentSize::store(chunk, contentSize);
+            request.code = ServerRequests::Codes::BEGIN_FILE_UPLOAD;
+            request.payloadSize = UploadPayload::SIZE;
+            request.payload = chunk;
+            sendRequest(request);
+            if (getResponse().code != ServerResponses::CONFIRM_MSG) {
+                logger_.serverError("Server refused to start the upload");
+                return response;
+            }
+            uploadKey = aes_key;
+            CryptoHandler::start_gcm_content(sessionCipher(uploadKey), header);
+            journal = UploadJournal{filePath_, fileSize, 0, 0, 0, std::string(clientId, 16), wrappedSessionKey_,
+                                    std::string(header, sizeof(header)), 0, 0, 0, 0};
+            try {
+                recordFileVersion(filePath_, journal);
+            } catch (const std::system_error& e) {
+                logger_.error(e.what());
+                return response;
+            }
+        }
+        resume = false;
+
+        // Stream the content from the last checkpoint, a chunk at a time - the first one starts with the content header
+        AESWrapper& cipher = sessionCipher(uploadKey);
+        CrcState crc{journal.crc, journal.crcLength};
+        size_t offset = journal.offset;
+        fileStream.clear();
+        fileStream.seekg(static_cast<std::streamoff>(journal.nextSegment * GCM_SEGMENT_SIZE));
+        auto acknowledged = [&]() {
+            if (getResponse().code != ServerResponses::CONFIRM_MSG) {
+                logger_.serverError("Server didn't acknowledge an upload chunk");
+                return false;
+            }
+            checkpoint();
+            return true;
+        };
+        CrcState sentCrc = crc;
+        size_t sentOffset = offset;
+        bool awaitingAck = false;
+        request.code = ServerRequests::Codes::SEND_FILE_CHUNK;
+        for (size_t first = journal.nextSegment; first < segments; first += UPLOAD_CHUNK_SEGMENTS) {
+            char* content = chunk + UploadPayload::SIZE;
+            size_t length = 0;
+            if (first == 0) {
+                std::memcpy(content, header, sizeof(header));
+                length = sizeof(header);
+            }
+            try {
+                length += CryptoHandler::encrypt_gcm_segments(fileStream, fileSize, first, UPLOAD_CHUNK_SEGMENTS,
+                                                              cipher, header, workerPool(), segmentBuffers_,
+                                                              content + length, crc);
+            } catch (const std::runtime_error& e) {
+                logger_.error((std::ostringstream() << "Failed encrypting file: " << e.what()).str());
+                return response;
+            }
+            UploadPayload::ChunkOffset::store(chunk, offset);
+            request.payloadSize = static_cast<uint32_t>(UploadPayload::SIZE + length);
+            sendRequest(request);
+            offset += length;
+
+            // The previous chunk's acknowledgement has arrived while this one was encrypted:
+            if (awaitingAck) {
+                journal.offset = sentOffset;
+                journal.nextSegment = first;
+                journal.crc = sentCrc.crc;
+                journal.crcLength = sentCrc.length;
+                if (!acknowledged()) {
+                    return response;
+                }
+            }
+            sentCrc = crc;
+            sentOffset = offset;
+            awaitingAck = true;
+        }
+        if (awaitingAck) {
+            journal.offset = sentOffset;
+            journal.nextSegment = segments;
+            journal.crc = sentCrc.crc;
+            journal.crcLength = sentCrc.length;
+            if (!acknowledged()) {
+                return response;
+            }
+        }
+        if (fileStream.peek() != std::char_traits<char>::eof()) {
+            logger_.error("File changed while it was being encrypted");
+            return response;
+        }
 
-    // Clean up
-    delete[] encrypted_file_request.payload;
+        // Ask the server to verify the whole content:
+        UploadPayload::ContentSize::store(chunk, contentSize);
+        request.code = ServerRequests::Codes::COMMIT_FILE_UPLOAD;
+        request.payloadSize = UploadPayload::SIZE;
+        sendRequest(request);
+        uploadCrc = crcFinalize(crc);
+        return getResponse();
+    }, 3, (char *)clientId, concluded);
+
+    // Only an upload the server confirmed as concluded, either way, is forgotten - an interrupted one leaves its
+    // journal behind for the next run to resume from
+    if (concluded) {
+        fileHandler.removeUploadJournal(filePath_);
+    } else {
+        logger_.info("Keeping the upload journal, the next run resumes the upload");
+    }
+    logger_.info((std::ostringstream() << "Upload made " << payloadArena_.heapAllocations() - heapAllocations
+                                       << " payload heap allocations").str());
     return status;
 }
 
@@ -357,6 +913,11 @@ bool ProtocolHandler::handleFileEncryptionAndSend(const std::string& encrypted_a
 bool ProtocolHandler::handleRegistration() {
     char clientId[16];
     logger_.info((std::ostringstream() << "Starting registration flow for client " << clientName_ << "...").str());
+    // Start generating the RSA pair while the registration request is in flight - unless the server is already known
+    // to speak X25519, which needs no RSA pair at all
+    if (serverVersion_ < X25519_KEY_EXCHANGE_PROTOCOL_VERSION) {
+        RSAKeyFactory::shared();
+    }
 
     // Step 1: Send registration request with an empty clientId + check if response is valid:
     logger_.info((std::ostringstream() << "Attempting to register " << clientName_ << " to server").str());
@@ -368,53 +929,102 @@ bool ProtocolHandler::handleRegistration() {
     logger_.info((std::ostringstream() << "successfully registered " << clientName_ << " to server").str());
 
     // Step 2: Handle RSA registration
-    logger_.info("Attempting to generate RSA pair and send public key to server");
+    logger_.info("Attempting to generate key pair and send public key to server");
     std::string privateKey;
-    serverResponse = handleRSARegistration(clientId, privateKey);
+    KeyType keyType;
+    serverResponse = handleKeyRegistration(clientId, privateKey, keyType);
 
     if (serverResponse.code != ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES) {
-        logger_.serverError("Received an invalid status from the server during RSA generation step");
-        return false;  // Exit if there was an error during RSA registration
+        logger_.serverError("Received an invalid status from the server during key generation step");
+        return false;  // Exit if there was an error during key registration
     }
-    logger_.info("Successfully generated RSA pair and received valid status and AES key from server");
+    logger_.info("Successfully generated key pair and received valid status and AES key from server");
 
     // Step 3: Encrypt file using AES key and send to the server
     logger_.info("Attempting to encrypt file using AES key and send to server");
-    std::string encrypted_aes_key = serverResponse.payload.substr(16);
-    return handleFileEncryptionAndSend(encrypted_aes_key, privateKey, clientId);
+    std::string encrypted_aes_key(serverResponse.payload.substr(16));
+    return handleFileEncryptionAndSend(encrypted_aes_key, keyType, privateKey, clientId);
+}
+
+/**
+ * Decrypts the AES key sent along with a reconnection approval, using the private key persisted in me.info.
+ * @param encrypted_aes_key The AES key received from the server, encrypted with the stored public key.
+ * @param keyType The type of the stored private key, as persisted in me.info.
+ * @param base64PrivateKey The private key as persisted in me.info, in Base64.
+ * @return The plain AES key, or an empty string if the stored key is missing or doesn't match the server's copy.
+ */
+std::string ProtocolHandler::decryptWithStoredKey(const std::string& encrypted_aes_key, KeyType keyType,
+                                                  const std::string& base64PrivateKey) {
+    if (base64PrivateKey.empty()) {
+        logger_.warning("No stored private key was found");
+        return "";
+    }
+    try {
+        return decryptAesKey(encrypted_aes_key, keyType, Base64Wrapper::decode(base64PrivateKey));
+    } catch (const std::exception& e) {
+        logger_.warning((std::ostringstream() << "Failed decrypting AES key using the stored private key: " << e.what()).str());
+        return "";
+    }
 }
 
 /**
  * Handles the reconnection process with the server. If the client doesn't exist yet, this method will fallback into
- * registration.
+ * registration. The AES key sent with the approval is decrypted using the stored private key, so no key pair has to
+ * be generated - unless a key rotation was requested, or the stored key can't be used.
+ * @param base64PrivateKey The private key persisted in me.info, in Base64.
+ * @param keyType The type of the private key persisted in me.info.
+ * @param rotateKey Whether to generate a new key pair and send its public key to the server.
+ * @param fallBack Whether a rejected reconnection may fall back into registration, and an unusable stored key into
+ * registering a new key pair - both rewrite me.info, so sessions running side by side must fail instead.
  * @return True if reconnection is successful, false otherwise.
  */
-bool ProtocolHandler::handleReconnection() {
+bool ProtocolHandler::handleReconnection(const std::string& base64PrivateKey, KeyType keyType, bool rotateKey,
+                                         bool fallBack) {
     char clientId[16];
     logger_.info((std::ostringstream() << "Starting reconnection flow for client " << clientName_ << "...").str());
+    auto start = std::chrono::steady_clock::now();
 
     // Step 1: Send registration request with an empty clientId + check if response is valid:
     Response serverResponse = ProtocolHandler::handleConnectionRequest(clientId, ServerRequests::Codes::RECONNECT);
     if (serverResponse.code == ServerResponses::RECONNECT_REJECTED) {
+        if (!fallBack) {
+            logger_.serverError("reconnection was rejected");
+            return false;
+        }
         // Try and to perform a registration request.
         return ProtocolHandler::handleRegistration();
     }
     else if(serverResponse.code != ServerResponses::APPROVE_RECONNECT_SEND_AES) {
-        logger_.serverError((std::ostringstream() << "failed to reconnect to the server - " << serverResponse.payload.c_str()).str());
+        logger_.serverError((std::ostringstream() << "failed to reconnect to the server - " << serverResponse.payload).str());
         return false;
     }
-    // Step 2: On successful reconnection, handle RSA registration
-    std::string privateKey;
-    serverResponse = handleRSARegistration(clientId, privateKey);
 
-    if (serverResponse.code != ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES) {
-        logger_.serverError("Received an invalid status from the server during RSA generation step");
-        return false;  // Exit if there was an error during RSA registration
+    // Step 2: Decrypt the AES key using the stored private key, falling back into key registration if needed
+    std::string aes_key;
+    if (!rotateKey && serverResponse.payload.size() > 16) {
+        aes_key = decryptWithStoredKey(std::string(serverResponse.payload.substr(16)), keyType, base64PrivateKey);
+    }
+    if (aes_key.empty() && !fallBack) {
+        logger_.error("The stored private key can't be used, and no new key pair may be registered");
+        return false;
+    }
+    if (aes_key.empty()) {
+        logger_.info("Attempting to generate key pair and send public key to server");
+        std::string privateKey;
+        KeyType newKeyType;
+        serverResponse = handleKeyRegistration(clientId, privateKey, newKeyType);
+
+        if (serverResponse.code != ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES) {
+            logger_.serverError("Received an invalid status from the server during key generation step");
+            return false;  // Exit if there was an error during key registration
+        }
+        logger_.info("Successfully generated key pair and received valid status and AES key from server");
+        aes_key = decryptAesKey(std::string(serverResponse.payload.substr(16)), newKeyType, privateKey);
     }
-    logger_.info("Successfully generated RSA pair and received valid status and AES key from server");
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    logger_.info((std::ostringstream() << "Reconnection key exchange took " << elapsed.count() / 1000.0 << " ms").str());
 
     // Step 3: Encrypt file using AES key and send to the server
     logger_.info("Attempting to encrypt file using AES key and send to server");
-    std::string encrypted_aes_key = serverResponse.payload.substr(16);
-    return handleFileEncryptionAndSend(encrypted_aes_key, privateKey, clientId);
+    return sendFiles(aes_key, clientId);
 }
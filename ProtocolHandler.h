@@ -7,7 +7,21 @@
 #define DEFENSIVE_MAMAN_15_PROTOCOLHANDLER_H
 
 #include <string>
+#include <string_view>
+#include <memory>
+#include <vector>
+#include <functional>
+#include <fstream>
 #include "Logger.h"
+#include "PayloadArena.h"
+#include "CryptoHandler.h"
+
+class AESWrapper;
+class RSAPrivateWrapper;
+class ThreadPool;
+class FileHandler;
+struct UploadJournal;
+struct iovec;
 
 struct Request {
     char clientId[16];
@@ -17,36 +31,82 @@ struct Request {
     char* payload;
 };
 
+// The payload points into the handler's receive buffer - it is only valid until the next response is received.
 struct Response {
     char version;
     uint16_t code;
     uint32_t payloadSize;
-    std::string payload;
+    std::string_view payload;
 };
 
 class ProtocolHandler {
 public:
-    ProtocolHandler(std::string  server_address, int port, std::string  name, std::string  filePath);
+    // Files at least this large are sent as a multi-part upload when the server supports it
+    static const size_t CHUNKED_UPLOAD_MIN_FILE_SIZE = size_t(64) << 20;
+    // The number of SEGMENTED_GCM segments sent in each SEND_FILE_CHUNK request
+    static const size_t UPLOAD_CHUNK_SEGMENTS = 8;
+
+    // Hands out the session's next file to send, returning false once there are none left
+    using FileSource = std::function<bool(std::string&)>;
+
+    ProtocolHandler(std::string  server_address, int port, std::string  name, std::vector<std::string>  filePaths,
+                    const std::string& loggerName = "ProtocolHandler");
     ~ProtocolHandler();
+    void setFileSource(FileSource fileSource);
+    void shareWorkerPool(std::shared_ptr<ThreadPool> workerPool);
+    size_t payloadHeapAllocations() const;
     bool handleConnection();
     bool handleRegistration();
-    bool handleReconnection();
+    bool handleReconnection(const std::string& base64PrivateKey, KeyType keyType, bool rotateKey = false,
+                            bool fallBack = true);
     void sendRequest(const Request& request);
     Response getResponse();
     static ssize_t safeReceive(int socket, void *buffer, size_t length, int flags);
     bool sendCRCStatusRequest(char *clientId, uint16_t code);
-    bool handleRetrySendFile(const Request& encrypted_content, int maxRetries, char *clientId);
+    bool handleRetrySendFile(const Request& encrypted_content, int maxRetries, char *clientId, uint32_t fileCrc);
     Response handleRSARegistration(char* clientId, std::string& outPrivateKey);
-    bool handleFileEncryptionAndSend(const std::string& encrypted_aes_key, const std::string& privateKey, const char* clientId);
+    Response handleX25519Registration(char* clientId, std::string& outPrivateKey);
+    Response handleKeyRegistration(char* clientId, std::string& outPrivateKey, KeyType& outKeyType);
+    bool handleFileEncryptionAndSend(const std::string& encrypted_aes_key, KeyType keyType, const std::string& privateKey,
+                                     const char* clientId);
     Response handleConnectionRequest(char *clientId, uint16_t requestCode);
 
 private:
     std::string serverAddress_;
     std::string clientName_;
-    std::string filePath_;
+    std::vector<std::string> filePaths_;
+    FileSource fileSource_;  // Overrides filePaths_ when set
+    std::string filePath_;  // The file currently being sent
     int socket_{};
     int port_;
+    char serverVersion_;
+    std::unique_ptr<AESWrapper> sessionCipher_;
+    RSADecryptorCache rsaDecryptor_;
+    std::shared_ptr<ThreadPool> workerPool_;
+    std::string wrappedSessionKey_;  // The session AES key as the server sent it, and the key that unwraps it -
+    std::string identityKey_;        // journaled so an interrupted upload can be resumed under the same key
+    KeyType identityKeyType_ = KeyType::RSA;
+    std::vector<char> receiveBuffer_;
+    PayloadArena payloadArena_;
+    GcmSegmentBuffers segmentBuffers_;
     Logger logger_;
+
+    void sendParts(iovec* parts, size_t count);
+    size_t receiveExactly(char* buffer, size_t length);
+    AESWrapper& sessionCipher(const std::string& aes_key);
+    ThreadPool& workerPool();
+    Response sendPublicKey(char* clientId, uint16_t code, char version, const std::string& publicKey,
+                           const std::string& privateKey, KeyType keyType);
+    std::string decryptAesKey(const std::string& encrypted_aes_key, KeyType keyType, const std::string& privateKey);
+    bool handleRetryUpload(const std::function<Response(uint32_t&)>& upload, int maxRetries, char *clientId,
+                           bool& concluded);
+    bool resumeUpload(FileHandler& fileHandler, std::istream& fileStream, Request& request, char* payload,
+                      size_t contentSize, UploadJournal& journal, std::string& aes_key);
+    bool sendFileInChunks(const std::string& aes_key, const char* clientId, std::ifstream& fileStream, size_t fileSize);
+    bool sendEncryptedFile(const std::string& aes_key, const char* clientId);
+    bool sendFiles(const std::string& aes_key, const char* clientId);
+    std::string decryptWithStoredKey(const std::string& encrypted_aes_key, KeyType keyType,
+                                     const std::string& base64PrivateKey);
 };
 
 
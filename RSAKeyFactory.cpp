@@ -0,0 +1,180 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Generate RSA key pairs ahead of time on the spare cores, so registration doesn't block on it.
+ */
+#include "RSAKeyFactory.h"
+#include "CryptoHandler.h"
+#include "FileHandler.h"
+#include <algorithm>
+
+/**
+ * Starts the generators, which keep up to stockSize key pairs ready. A persistent factory starts from the stock a
+ * previous run left on disk, and leaves its own unused stock there when destroyed.
+ * @param stockSize The maximal number of key pairs kept in stock (at least one is always kept).
+ * @param generatorCount The number of generator threads (at least one, at most one per key pair in stock).
+ * @param persistStock Whether to keep the stock on disk between runs.
+ */
+RSAKeyFactory::RSAKeyFactory(size_t stockSize, unsigned int generatorCount, bool persistStock)
+        : stockSize_(std::max<size_t>(stockSize, 1)), persistStock_(persistStock) {
+    if (persistStock_) {
+        for (auto& keyPair : FileHandler().takeKeyStock()) {
+            if (stock_.size() < stockSize_) {
+                stock_.push_back(std::move(keyPair));
+            } else {
+                std::fill(keyPair.second.begin(), keyPair.second.end(), '\0');
+            }
+        }
+    }
+    generatorCount = static_cast<unsigned int>(std::clamp<size_t>(generatorCount, 1, stockSize_));
+    for (unsigned int i = 0; i < generatorCount; ++i) {
+        generators_.emplace_back(&RSAKeyFactory::generatorLoop, this);
+    }
+}
+
+/**
+ * Stops the generators (after the key pairs they're working on, if any), saves the unused key pairs of a persistent
+ * factory for the next run, and wipes their private keys from memory. Callbacks still waiting for a pair are dropped.
+ */
+RSAKeyFactory::~RSAKeyFactory() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    stockChanged_.notify_all();
+    for (std::thread& generator : generators_) {
+        generator.join();
+    }
+    if (persistStock_ && !stock_.empty()) {
+        try {
+            FileHandler().saveKeyStock({stock_.begin(), stock_.end()});
+        } catch (const std::exception&) {
+            // Losing the stock only costs the next run the time to generate it again
+        }
+    }
+    for (auto& keyPair : stock_) {
+        std::fill(keyPair.second.begin(), keyPair.second.end(), '\0');
+    }
+}
+
+/**
+ * Gets the process wide factory, starting it on first use - so calling it early lets the first key pair be generated
+ * while the client is busy with other work (e.g. connecting to the server). Its stock is kept on disk between runs.
+ * @return The shared factory.
+ */
+RSAKeyFactory& RSAKeyFactory::shared() {
+    static RSAKeyFactory factory(DEFAULT_STOCK_SIZE, defaultGeneratorCount(), true);
+    return factory;
+}
+
+/**
+ * Gets the number of generators to use when none is specified - one per spare hardware thread, leaving one for the
+ * client's own flows.
+ * @return The number of hardware threads but one, or 1 if there are no spare ones.
+ */
+unsigned int RSAKeyFactory::defaultGeneratorCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count > 1 ? count - 1 : 1;
+}
+
+/**
+ * Takes the next ready key pair out of the stock, waiting for the generators only if the stock is empty.
+ * @throws std::exception Whatever a generator failed with, if it failed and the stock ran out.
+ * @return A pair containing the public key and private key as strings.
+ */
+std::pair<std::string, std::string> RSAKeyFactory::take() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    stockChanged_.wait(lock, [this]() { return !stock_.empty() || failure_; });
+    if (stock_.empty()) {
+        std::rethrow_exception(failure_);
+    }
+    std::pair<std::string, std::string> keyPair = std::move(stock_.front());
+    stock_.pop_front();
+    lock.unlock();
+    stockChanged_.notify_all();  // Let the generators refill the stock
+    return keyPair;
+}
+
+/**
+ * Takes the next ready key pair without waiting for it - for callers that must not block, like the event loop's. The
+ * callback runs right away on the calling thread if the stock has a pair, and on a generator thread once one was
+ * generated otherwise - so it should only hand the pair over to where it is used.
+ * @param callback Receives the key pair, or the error a generator failed with if it failed and the stock ran out.
+ */
+void RSAKeyFactory::take(KeyPairCallback callback) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (stock_.empty() && !failure_) {
+        waiting_.push_back(std::move(callback));
+        lock.unlock();
+        stockChanged_.notify_all();  // Let a generator take the waiting callback on
+        return;
+    }
+    std::pair<std::string, std::string> keyPair;
+    std::exception_ptr error = failure_;
+    if (!stock_.empty()) {
+        keyPair = std::move(stock_.front());
+        stock_.pop_front();
+        error = nullptr;
+    }
+    lock.unlock();
+    stockChanged_.notify_all();
+    callback(std::move(keyPair), error);
+}
+
+/**
+ * Gets the number of key pairs that can currently be taken without waiting.
+ * @return The number of key pairs in stock.
+ */
+size_t RSAKeyFactory::available() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stock_.size();
+}
+
+/**
+ * Generates key pairs while the stock and the waiting callbacks call for more than the other generators are working
+ * on, then sleeps until a pair is taken or the factory is destroyed. A generated pair goes to the first waiting
+ * callback if there is one, and into the stock otherwise. The generation itself runs without holding the lock, so
+ * take() is never blocked by it while pairs are in stock.
+ */
+void RSAKeyFactory::generatorLoop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        stockChanged_.wait(lock, [this]() {
+            return stopping_ || failure_ || stock_.size() + generating_ < stockSize_ + waiting_.size();
+        });
+        if (stopping_ || failure_) {
+            return;
+        }
+        generating_++;
+        lock.unlock();
+        std::pair<std::string, std::string> keyPair;
+        try {
+            keyPair = CryptoHandler::generate_rsa_key_pair();
+        } catch (...) {
+            lock.lock();
+            generating_--;
+            failure_ = std::current_exception();
+            std::exception_ptr error = failure_;
+            std::deque<KeyPairCallback> failed = std::move(waiting_);
+            waiting_.clear();
+            lock.unlock();
+            stockChanged_.notify_all();
+            for (KeyPairCallback& callback : failed) {
+                callback({}, error);
+            }
+            return;
+        }
+        lock.lock();
+        generating_--;
+        if (!waiting_.empty()) {
+            KeyPairCallback callback = std::move(waiting_.front());
+            waiting_.pop_front();
+            lock.unlock();
+            callback(std::move(keyPair), nullptr);
+            lock.lock();
+        } else {
+            stock_.push_back(std::move(keyPair));
+        }
+        stockChanged_.notify_all();
+    }
+}
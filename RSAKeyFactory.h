@@ -0,0 +1,55 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for RSAKeyFactory.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_RSAKEYFACTORY_H
+#define DEFENSIVE_MAMAN_15_RSAKEYFACTORY_H
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+class RSAKeyFactory {
+public:
+    static const size_t DEFAULT_STOCK_SIZE = 4;
+
+    // Receives a key pair (public key, private key), or the error the generators failed with
+    using KeyPairCallback = std::function<void(std::pair<std::string, std::string> keyPair, std::exception_ptr error)>;
+
+    explicit RSAKeyFactory(size_t stockSize = DEFAULT_STOCK_SIZE, unsigned int generatorCount = defaultGeneratorCount(),
+                           bool persistStock = false);
+    ~RSAKeyFactory();
+    RSAKeyFactory(const RSAKeyFactory&) = delete;
+    RSAKeyFactory& operator=(const RSAKeyFactory&) = delete;
+
+    static RSAKeyFactory& shared();
+    static unsigned int defaultGeneratorCount();
+    std::pair<std::string, std::string> take();
+    void take(KeyPairCallback callback);
+    size_t available();
+
+private:
+    void generatorLoop();
+
+    size_t stockSize_;
+    bool persistStock_;
+    std::deque<std::pair<std::string, std::string>> stock_;
+    std::deque<KeyPairCallback> waiting_;  // Callbacks waiting for the next generated pair, served before the stock
+    size_t generating_ = 0;
+    std::exception_ptr failure_;
+    std::mutex mutex_;
+    std::condition_variable stockChanged_;
+    bool stopping_ = false;
+    std::vector<std::thread> generators_;
+};
+
+
+#endif
@@ -3,16 +3,18 @@
 //
 
 #include "RSAWrapper.h"
-#include "Base64Wrapper.h"
+#include "cryptopp/base64.h"
 
 
 RSAPublicWrapper::RSAPublicWrapper(const char* key, unsigned int length)
+    : _rng(RandomService::generator())
 {
     CryptoPP::StringSource ss(reinterpret_cast<const CryptoPP::byte*>(key), length, true);
     _publicKey.Load(ss);
 }
 
 RSAPublicWrapper::RSAPublicWrapper(const std::string& key)
+    : _rng(RandomService::generator())
 {
     CryptoPP::StringSource ss(key, true);
     _publicKey.Load(ss);
@@ -56,20 +58,31 @@ std::string RSAPublicWrapper::encrypt(const char* plain, unsigned int length)
 
 
 RSAPrivateWrapper::RSAPrivateWrapper()
+    : _rng(RandomService::generator())
 {
     _privateKey.Initialize(_rng, BITS);
+    setupDecryptor();
 }
 
 RSAPrivateWrapper::RSAPrivateWrapper(const char* key, unsigned int length)
+    : _rng(RandomService::generator())
 {
     CryptoPP::StringSource ss(reinterpret_cast<const CryptoPP::byte*>(key), length, true);
     _privateKey.Load(ss);
+    setupDecryptor();
 }
 
 RSAPrivateWrapper::RSAPrivateWrapper(const std::string& key)
+    : _rng(RandomService::generator())
 {
     CryptoPP::StringSource ss(key, true);
     _privateKey.Load(ss);
+    setupDecryptor();
+}
+
+void RSAPrivateWrapper::setupDecryptor()
+{
+    _decryptor.reset(new CryptoPP::RSAES_OAEP_SHA_Decryptor(_privateKey));
 }
 
 RSAPrivateWrapper::~RSAPrivateWrapper()
@@ -120,18 +133,16 @@ char* RSAPrivateWrapper::getPublicKey(char* keyout, unsigned int length) const
     return keyout;
 }
 
-std::string RSAPrivateWrapper::decrypt(const std::string& cipher)
+std::string RSAPrivateWrapper::decrypt(const std::string& cipher) const
 {
     std::string decrypted;
-    CryptoPP::RSAES_OAEP_SHA_Decryptor d(_privateKey);
-    CryptoPP::StringSource ss_cipher(cipher, true, new CryptoPP::PK_DecryptorFilter(_rng, d, new CryptoPP::StringSink(decrypted)));
+    CryptoPP::StringSource ss_cipher(cipher, true, new CryptoPP::PK_DecryptorFilter(_rng, *_decryptor, new CryptoPP::StringSink(decrypted)));
     return decrypted;
 }
 
-std::string RSAPrivateWrapper::decrypt(const char* cipher, unsigned int length)
+std::string RSAPrivateWrapper::decrypt(const char* cipher, unsigned int length) const
 {
     std::string decrypted;
-    CryptoPP::RSAES_OAEP_SHA_Decryptor d(_privateKey);
-    CryptoPP::StringSource ss_cipher(reinterpret_cast<const CryptoPP::byte*>(cipher), length, true, new CryptoPP::PK_DecryptorFilter(_rng, d, new CryptoPP::StringSink(decrypted)));
+    CryptoPP::StringSource ss_cipher(reinterpret_cast<const CryptoPP::byte*>(cipher), length, true, new CryptoPP::PK_DecryptorFilter(_rng, *_decryptor, new CryptoPP::StringSink(decrypted)));
     return decrypted;
 }
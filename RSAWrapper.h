@@ -5,10 +5,11 @@
 #ifndef DEFENSIVE_MAMAN_15_RSAWRAPPER_H
 #define DEFENSIVE_MAMAN_15_RSAWRAPPER_H
 
-#include "cryptopp/osrng.h"
 #include "cryptopp/rsa.h"
+#include "RandomService.h"
 
 #include <string>
+#include <memory>
 
 
 
@@ -19,7 +20,7 @@ public:
     static const unsigned int BITS = 1024;
 
 private:
-    CryptoPP::AutoSeededRandomPool _rng;
+    CryptoPP::RandomNumberGenerator& _rng;
     CryptoPP::RSA::PublicKey _publicKey;
 
     RSAPublicWrapper(const RSAPublicWrapper& rsapublic);
@@ -44,8 +45,11 @@ public:
     static const unsigned int BITS = 1024;
 
 private:
-    CryptoPP::AutoSeededRandomPool _rng;
+    CryptoPP::RandomNumberGenerator& _rng;
     CryptoPP::RSA::PrivateKey _privateKey;
+    std::unique_ptr<CryptoPP::RSAES_OAEP_SHA_Decryptor> _decryptor;
+
+    void setupDecryptor();
 
     RSAPrivateWrapper(const RSAPrivateWrapper& rsaprivate);
     RSAPrivateWrapper& operator=(const RSAPrivateWrapper& rsaprivate);
@@ -61,8 +65,8 @@ public:
     std::string getPublicKey() const;
     char* getPublicKey(char* keyout, unsigned int length) const;
 
-    std::string decrypt(const std::string& cipher);
-    std::string decrypt(const char* cipher, unsigned int length);
+    std::string decrypt(const std::string& cipher) const;
+    std::string decrypt(const char* cipher, unsigned int length) const;
 };
 
 
@@ -0,0 +1,216 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Provide batched, per-thread cryptographically secure random bytes to the AES, RSA and IV generation code.
+ */
+#include "RandomService.h"
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#if defined(__linux__) || defined(__APPLE__)
+#include <sys/random.h>
+#endif
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RANDOM_HAVE_RDRAND 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Bumped in the child after fork(), so a forked process never hands out bytes its parent already buffered.
+std::atomic<unsigned int> forkGeneration{0};
+
+struct ThreadBatch {
+    unsigned char bytes[RandomService::BATCH_SIZE];
+    size_t available = 0;
+    unsigned int generation = 0;
+
+    ~ThreadBatch() {
+        std::memset(bytes, 0, sizeof(bytes));
+    }
+};
+
+ThreadBatch& threadBatch() {
+    static const int registered = pthread_atfork(nullptr, nullptr, [] { forkGeneration.fetch_add(1); });
+    (void)registered;
+    thread_local ThreadBatch batch;
+    return batch;
+}
+
+/**
+ * Reads from the OS CSPRNG until the buffer is full, retrying interrupted calls.
+ * @throws std::system_error If the OS source fails.
+ */
+void readOsRandom(unsigned char* out, size_t length) {
+#if defined(__linux__)
+    while (length > 0) {
+        ssize_t got = getrandom(out, length, 0);
+        if (got < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::system_category(), "getrandom failed");
+        }
+        out += got;
+        length -= static_cast<size_t>(got);
+    }
+#elif defined(__APPLE__)
+    while (length > 0) {
+        size_t chunk = length < 256 ? length : 256;  // getentropy is limited to 256 bytes per call
+        if (getentropy(out, chunk) != 0) {
+            throw std::system_error(errno, std::system_category(), "getentropy failed");
+        }
+        out += chunk;
+        length -= chunk;
+    }
+#else
+    int fd = open("/dev/urandom", O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        throw std::system_error(errno, std::system_category(), "failed to open /dev/urandom");
+    }
+    while (length > 0) {
+        ssize_t got = read(fd, out, length);
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            int error = got < 0 ? errno : EIO;
+            close(fd);
+            throw std::system_error(error, std::system_category(), "failed to read /dev/urandom");
+        }
+        out += got;
+        length -= static_cast<size_t>(got);
+    }
+    close(fd);
+#endif
+}
+
+#ifdef RANDOM_HAVE_RDRAND
+#if defined(__x86_64__)
+typedef unsigned long long RdrandWord;
+__attribute__((target("rdrnd")))
+inline int rdrandStep(RdrandWord* word) {
+    return _rdrand64_step(word);
+}
+#else
+typedef unsigned int RdrandWord;
+__attribute__((target("rdrnd")))
+inline int rdrandStep(RdrandWord* word) {
+    return _rdrand32_step(word);
+}
+#endif
+
+bool cpuHasRdrand() {
+    unsigned int eax, ebx, ecx, edx;
+    return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & (1u << 30));
+}
+
+/**
+ * XORs RDRAND output into the buffer. Every step is checked and retried a bounded number of times (RDRAND may
+ * transiently underflow); if the instruction keeps failing the buffer simply keeps the OS bytes it already holds.
+ * @return True if the whole buffer was mixed, false if RDRAND gave up.
+ */
+__attribute__((target("rdrnd")))
+bool mixRdrand(unsigned char* out, size_t length) {
+    const int RETRIES = 10;
+    for (size_t offset = 0; offset < length; offset += sizeof(RdrandWord)) {
+        RdrandWord word = 0;
+        int attempt = 0;
+        while (!rdrandStep(&word)) {
+            if (++attempt == RETRIES) {
+                return false;
+            }
+        }
+        size_t take = length - offset < sizeof(word) ? length - offset : sizeof(word);
+        for (size_t i = 0; i < take; ++i) {
+            out[offset + i] ^= static_cast<unsigned char>(word >> (8 * i));
+        }
+    }
+    return true;
+}
+#endif
+
+// Crypto++ facing adapter, so RSA key generation and OAEP padding draw from the same batches.
+class ServiceGenerator : public CryptoPP::RandomNumberGenerator {
+public:
+    void GenerateBlock(CryptoPP::byte* output, size_t size) override {
+        RandomService::generate(output, size);
+    }
+
+    std::string AlgorithmName() const override {
+        return "RandomService";
+    }
+};
+
+} // namespace
+
+/**
+ * Fills a buffer straight from the entropy sources: the OS CSPRNG, with checked RDRAND output mixed in when available.
+ * @param out The buffer to fill.
+ * @param length The number of bytes to generate.
+ * @throws std::system_error If the OS source fails.
+ */
+void RandomService::fillFromSources(unsigned char* out, size_t length) {
+    readOsRandom(out, length);
+#ifdef RANDOM_HAVE_RDRAND
+    static const bool hasRdrand = cpuHasRdrand();
+    if (hasRdrand) {
+        mixRdrand(out, length);
+    }
+#endif
+}
+
+/**
+ * Generates cryptographically secure random bytes. Small requests (keys, IVs, nonces) are served from the calling
+ * thread's batch, which is refilled BATCH_SIZE bytes at a time; requests larger than a batch go to the sources directly.
+ * Handed out bytes are wiped from the batch.
+ * @param out The buffer to fill.
+ * @param length The number of bytes to generate.
+ * @throws std::system_error If the OS source fails.
+ */
+void RandomService::generate(unsigned char* out, size_t length) {
+    if (length >= BATCH_SIZE) {
+        fillFromSources(out, length);
+        return;
+    }
+
+    ThreadBatch& batch = threadBatch();
+    unsigned int generation = forkGeneration.load(std::memory_order_relaxed);
+    if (batch.generation != generation) {
+        std::memset(batch.bytes, 0, sizeof(batch.bytes));
+        batch.available = 0;
+        batch.generation = generation;
+    }
+
+    while (length > 0) {
+        if (batch.available == 0) {
+            fillFromSources(batch.bytes, BATCH_SIZE);
+            batch.available = BATCH_SIZE;
+        }
+        size_t take = length < batch.available ? length : batch.available;
+        unsigned char* source = batch.bytes + (BATCH_SIZE - batch.available);
+        std::memcpy(out, source, take);
+        std::memset(source, 0, take);
+        batch.available -= take;
+        out += take;
+        length -= take;
+    }
+}
+
+/**
+ * Gets a Crypto++ random number generator backed by this service, for APIs that take one (RSA key generation,
+ * OAEP). The generator holds no state of its own, so it can be shared between threads.
+ * @return The shared generator.
+ */
+CryptoPP::RandomNumberGenerator& RandomService::generator() {
+    static ServiceGenerator instance;
+    return instance;
+}
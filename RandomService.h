@@ -0,0 +1,28 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for RandomService.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_RANDOMSERVICE_H
+#define DEFENSIVE_MAMAN_15_RANDOMSERVICE_H
+
+#include <cstddef>
+#include <string>
+#include "cryptopp/cryptlib.h"
+
+// Process wide source of cryptographically secure random bytes for keys and IVs. Every thread keeps its own batch of
+// random bytes, refilled in BATCH_SIZE blocks from the OS CSPRNG (getrandom / getentropy / urandom) with RDRAND output
+// mixed in when the CPU offers it - so a 16 byte IV costs a copy out of the batch, not a reseed or a syscall.
+class RandomService {
+public:
+    static const size_t BATCH_SIZE = 4096;
+
+    static void generate(unsigned char* out, size_t length);
+    static CryptoPP::RandomNumberGenerator& generator();
+
+private:
+    static void fillFromSources(unsigned char* out, size_t length);
+};
+
+
+#endif
@@ -0,0 +1,110 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: A minimal coroutine task type, letting the protocol flows await I/O and offloaded work while still reading
+ * as linear code.
+ */
+#ifndef DEFENSIVE_MAMAN_15_TASK_H
+#define DEFENSIVE_MAMAN_15_TASK_H
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <utility>
+
+template <typename T = void>
+class Task;
+
+namespace TaskDetail {
+    // Resumes whoever awaits the task once it completes - symmetric transfer, so chains of awaited tasks don't grow
+    // the stack.
+    struct FinalAwaiter {
+        bool await_ready() noexcept { return false; }
+        template <typename Promise>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> finished) noexcept {
+            std::coroutine_handle<> continuation = finished.promise().continuation;
+            return continuation ? continuation : std::noop_coroutine();
+        }
+        void await_resume() noexcept {}
+    };
+
+    struct PromiseBase {
+        std::coroutine_handle<> continuation;
+        std::exception_ptr error;
+
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        FinalAwaiter final_suspend() noexcept { return {}; }
+        void unhandled_exception() { error = std::current_exception(); }
+        void rethrowIfFailed() const {
+            if (error) {
+                std::rethrow_exception(error);
+            }
+        }
+    };
+
+    template <typename T>
+    struct Promise : PromiseBase {
+        std::optional<T> value;
+
+        Task<T> get_return_object();
+        void return_value(T result) { value.emplace(std::move(result)); }
+        T result() {
+            rethrowIfFailed();
+            return std::move(*value);
+        }
+    };
+
+    template <>
+    struct Promise<void> : PromiseBase {
+        Task<void> get_return_object();
+        void return_void() {}
+        void result() { rethrowIfFailed(); }
+    };
+}
+
+// A lazily started coroutine producing a T. Awaiting it from another coroutine starts it, and resumes the awaiting
+// coroutine with its result (or exception) once it completes. A top-level task is started with start(), and its
+// result read with result() once done().
+template <typename T>
+class Task {
+public:
+    using promise_type = TaskDetail::Promise<T>;
+
+    explicit Task(std::coroutine_handle<promise_type> handle) : handle_(handle) {}
+    Task(Task&& other) noexcept : handle_(std::exchange(other.handle_, {})) {}
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() {
+        if (handle_) {
+            handle_.destroy();
+        }
+    }
+
+    bool await_ready() const noexcept { return false; }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+        handle_.promise().continuation = awaiting;
+        return handle_;
+    }
+    T await_resume() { return handle_.promise().result(); }
+
+    void start() { handle_.resume(); }
+    bool done() const { return handle_.done(); }
+    T result() { return handle_.promise().result(); }
+
+private:
+    std::coroutine_handle<promise_type> handle_;
+};
+
+namespace TaskDetail {
+    template <typename T>
+    Task<T> Promise<T>::get_return_object() {
+        return Task<T>(std::coroutine_handle<Promise<T>>::from_promise(*this));
+    }
+
+    inline Task<void> Promise<void>::get_return_object() {
+        return Task<void>(std::coroutine_handle<Promise<void>>::from_promise(*this));
+    }
+}
+
+
+#endif
@@ -0,0 +1,70 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Provide a fixed-size pool of worker threads for CPU heavy client-side work (CRC, encryption, etc.).
+ */
+#include "ThreadPool.h"
+
+/**
+ * Starts the requested number of worker threads.
+ * @param threadCount The number of workers to start (at least one worker is always started).
+ */
+ThreadPool::ThreadPool(unsigned int threadCount) {
+    if (threadCount == 0) {
+        threadCount = 1;
+    }
+    workers_.reserve(threadCount);
+    for (unsigned int i = 0; i < threadCount; ++i) {
+        workers_.emplace_back(&ThreadPool::workerLoop, this);
+    }
+}
+
+/**
+ * Lets the workers drain the remaining queued tasks and joins them.
+ */
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    condition_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+}
+
+/**
+ * Gets the number of workers to use when none is specified - one per hardware thread.
+ * @return The number of hardware threads, or 1 if it cannot be determined.
+ */
+unsigned int ThreadPool::defaultThreadCount() {
+    unsigned int count = std::thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+/**
+ * Gets the number of workers in the pool.
+ * @return The number of worker threads.
+ */
+unsigned int ThreadPool::size() const {
+    return static_cast<unsigned int>(workers_.size());
+}
+
+/**
+ * Runs queued tasks until the pool is being destroyed and the queue is empty.
+ */
+void ThreadPool::workerLoop() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            condition_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+            if (tasks_.empty()) {
+                return;
+            }
+            task = std::move(tasks_.front());
+            tasks_.pop();
+        }
+        task();
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Describe the request / response header layouts at compile time, and encode / decode their fields.
+ */
+#ifndef DEFENSIVE_MAMAN_15_WIREFORMAT_H
+#define DEFENSIVE_MAMAN_15_WIREFORMAT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace WireFormat {
+    enum class ByteOrder { LITTLE, BIG };
+
+    /**
+     * An unsigned integer field at a fixed offset of a header. Loads and stores are unrolled shifts over a constant
+     * number of bytes, which the compiler folds into a single (byte swapped, if needed) load or store - independent
+     * of the host's byte order and of how it would lay the field out in a struct.
+     * @tparam T The field's unsigned integer type.
+     * @tparam Offset The field's offset in the header.
+     * @tparam Order The field's byte order on the wire.
+     */
+    template <typename T, size_t Offset, ByteOrder Order>
+    struct Field {
+        static constexpr size_t OFFSET = Offset;
+        static constexpr size_t SIZE = sizeof(T);
+        static constexpr size_t END = Offset + sizeof(T);
+
+        static constexpr size_t shift(size_t i) {
+            return 8 * (Order == ByteOrder::LITTLE ? i : SIZE - 1 - i);
+        }
+
+        static constexpr void store(char* header, T value) {
+            for (size_t i = 0; i < SIZE; ++i) {
+                header[Offset + i] = static_cast<char>(static_cast<uint8_t>(value >> shift(i)));
+            }
+        }
+
+        static constexpr T load(const char* header) {
+            T value = 0;
+            for (size_t i = 0; i < SIZE; ++i) {
+                value |= static_cast<T>(static_cast<T>(static_cast<uint8_t>(header[Offset + i])) << shift(i));
+            }
+            return value;
+        }
+    };
+
+    /**
+     * A fixed-size byte string field at a fixed offset of a header.
+     * @tparam Offset The field's offset in the header.
+     * @tparam Size The field's size in bytes.
+     */
+    template <size_t Offset, size_t Size>
+    struct Bytes {
+        static constexpr size_t OFFSET = Offset;
+        static constexpr size_t SIZE = Size;
+        static constexpr size_t END = Offset + Size;
+
+        static void store(char* header, const char* value) {
+            std::memcpy(header + Offset, value, Size);
+        }
+
+        static void load(const char* header, char* value) {
+            std::memcpy(value, header + Offset, Size);
+        }
+    };
+
+    // Client ID (16 bytes) + version (1 byte) + code (2 bytes) + payload size (4 bytes), little endian
+    namespace RequestHeader {
+        using ClientId = Bytes<0, 16>;
+        using Version = Field<uint8_t, ClientId::END, ByteOrder::LITTLE>;
+        using Code = Field<uint16_t, Version::END, ByteOrder::LITTLE>;
+        using PayloadSize = Field<uint32_t, Code::END, ByteOrder::LITTLE>;
+        constexpr size_t SIZE = PayloadSize::END;
+    }
+
+    // Version (1 byte) + code (2 bytes) + payload size (4 bytes), in network byte order
+    namespace ResponseHeader {
+        using Version = Field<uint8_t, 0, ByteOrder::BIG>;
+        using Code = Field<uint16_t, Version::END, ByteOrder::BIG>;
+        using PayloadSize = Field<uint32_t, Code::END, ByteOrder::BIG>;
+        constexpr size_t SIZE = PayloadSize::END;
+    }
+
+    // Multi-part upload payloads - the file name field is followed by the total encrypted content size (BEGIN and
+    // COMMIT) or by the offset of the chunk's content within it (CHUNK, followed by the content itself)
+    namespace UploadPayload {
+        using FileName = Bytes<0, 255>;
+        using ContentSize = Field<uint64_t, FileName::END, ByteOrder::BIG>;
+        using ChunkOffset = Field<uint64_t, FileName::END, ByteOrder::BIG>;
+        constexpr size_t SIZE = ContentSize::END;
+    }
+
+    // The server's answer to RESUME_FILE_UPLOAD - how much of the upload's content it already holds
+    namespace UploadProgress {
+        using ClientId = Bytes<0, 16>;
+        using ReceivedSize = Field<uint64_t, ClientId::END, ByteOrder::BIG>;
+        constexpr size_t SIZE = ReceivedSize::END;
+    }
+
+    static_assert(RequestHeader::SIZE == 23, "request header must be 23 bytes");
+    static_assert(ResponseHeader::SIZE == 7, "response header must be 7 bytes");
+}
+
+
+#endif
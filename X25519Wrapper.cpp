@@ -0,0 +1,113 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Wrap Crypto++'s X25519 key agreement, for receiving the session's AES key without RSA.
+ */
+#include "X25519Wrapper.h"
+#include "RandomService.h"
+#include "cryptopp/hkdf.h"
+#include "cryptopp/sha.h"
+
+#include <stdexcept>
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+    const char WRAP_INFO[] = "defensive_maman_15 x25519 aes key";
+}
+
+X25519Wrapper::X25519Wrapper()
+{
+    _x25519.GenerateKeyPair(RandomService::generator(), _privateKey, _publicKey);
+}
+
+X25519Wrapper::X25519Wrapper(const std::string& key)
+{
+    if (key.size() != KEY_LENGTH)
+        throw std::length_error("X25519 private key must be 32 bytes");
+    CryptoPP::memcpy_s(_privateKey, KEY_LENGTH, key.data(), key.size());
+    _x25519.GeneratePublicKey(RandomService::generator(), _privateKey, _publicKey);
+}
+
+X25519Wrapper::~X25519Wrapper()
+{
+    std::fill(std::begin(_privateKey), std::end(_privateKey), 0);
+}
+
+std::string X25519Wrapper::getPrivateKey() const
+{
+    return std::string(reinterpret_cast<const char*>(_privateKey), KEY_LENGTH);
+}
+
+std::string X25519Wrapper::getPublicKey() const
+{
+    return std::string(reinterpret_cast<const char*>(_publicKey), KEY_LENGTH);
+}
+
+// Derives the key encryption key and nonce of a wrapped AES key from the agreed secret, using HKDF-SHA256
+void X25519Wrapper::deriveWrapKey(const CryptoPP::byte* secret, const CryptoPP::byte* ephemeralKey,
+                                  const CryptoPP::byte* clientKey, CryptoPP::byte* derived)
+{
+    CryptoPP::byte salt[2 * KEY_LENGTH];
+    CryptoPP::memcpy_s(salt, sizeof(salt), ephemeralKey, KEY_LENGTH);
+    CryptoPP::memcpy_s(salt + KEY_LENGTH, KEY_LENGTH, clientKey, KEY_LENGTH);
+
+    CryptoPP::HKDF<CryptoPP::SHA256> hkdf;
+    hkdf.DeriveKey(derived, AESWrapper::DEFAULT_KEYLENGTH + AESWrapper::GCM_NONCE_LENGTH, secret, KEY_LENGTH,
+                   salt, sizeof(salt), reinterpret_cast<const CryptoPP::byte*>(WRAP_INFO), sizeof(WRAP_INFO) - 1);
+}
+
+std::string X25519Wrapper::unwrap(const std::string& wrapped) const
+{
+    if (wrapped.size() != WRAPPED_KEY_LENGTH)
+        throw std::length_error("wrapped AES key has an invalid length");
+    const CryptoPP::byte* ephemeralKey = reinterpret_cast<const CryptoPP::byte*>(wrapped.data());
+
+    // Rejects low order points, which would make the agreed secret predictable
+    CryptoPP::byte secret[KEY_LENGTH];
+    if (!_x25519.Agree(secret, _privateKey, ephemeralKey, true))
+        throw std::runtime_error("server sent an invalid ephemeral X25519 key");
+
+    CryptoPP::byte derived[AESWrapper::DEFAULT_KEYLENGTH + AESWrapper::GCM_NONCE_LENGTH];
+    deriveWrapKey(secret, ephemeralKey, _publicKey, derived);
+
+    AESWrapper keyEncryptionKey(derived, AESWrapper::DEFAULT_KEYLENGTH);
+    std::string aesKey(AESWrapper::DEFAULT_KEYLENGTH, '\0');
+    bool valid = keyEncryptionKey.decryptGcm(derived + AESWrapper::DEFAULT_KEYLENGTH, nullptr, 0,
+                                             wrapped.data() + KEY_LENGTH, AESWrapper::DEFAULT_KEYLENGTH,
+                                             reinterpret_cast<const unsigned char*>(wrapped.data()) + KEY_LENGTH + AESWrapper::DEFAULT_KEYLENGTH,
+                                             &aesKey[0]);
+    std::fill(std::begin(secret), std::end(secret), 0);
+    std::fill(std::begin(derived), std::end(derived), 0);
+    if (!valid)
+        throw std::runtime_error("failed to unwrap AES key");
+    return aesKey;
+}
+
+std::string X25519Wrapper::wrap(const std::string& publicKey, const std::string& aesKey)
+{
+    if (publicKey.size() != KEY_LENGTH)
+        throw std::length_error("X25519 public key must be 32 bytes");
+    if (aesKey.size() != AESWrapper::DEFAULT_KEYLENGTH)
+        throw std::length_error("AES key must be 16 bytes");
+    const CryptoPP::byte* clientKey = reinterpret_cast<const CryptoPP::byte*>(publicKey.data());
+
+    X25519Wrapper ephemeral;
+    CryptoPP::byte secret[KEY_LENGTH];
+    if (!ephemeral._x25519.Agree(secret, ephemeral._privateKey, clientKey, true))
+        throw std::runtime_error("client sent an invalid X25519 public key");
+
+    CryptoPP::byte derived[AESWrapper::DEFAULT_KEYLENGTH + AESWrapper::GCM_NONCE_LENGTH];
+    deriveWrapKey(secret, ephemeral._publicKey, clientKey, derived);
+
+    std::string wrapped(WRAPPED_KEY_LENGTH, '\0');
+    CryptoPP::memcpy_s(&wrapped[0], KEY_LENGTH, ephemeral._publicKey, KEY_LENGTH);
+    AESWrapper keyEncryptionKey(derived, AESWrapper::DEFAULT_KEYLENGTH);
+    keyEncryptionKey.encryptGcm(derived + AESWrapper::DEFAULT_KEYLENGTH, nullptr, 0,
+                                aesKey.data(), AESWrapper::DEFAULT_KEYLENGTH, &wrapped[KEY_LENGTH],
+                                reinterpret_cast<unsigned char*>(&wrapped[KEY_LENGTH + AESWrapper::DEFAULT_KEYLENGTH]));
+    std::fill(std::begin(secret), std::end(secret), 0);
+    std::fill(std::begin(derived), std::end(derived), 0);
+    return wrapped;
+}
@@ -0,0 +1,49 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for X25519Wrapper.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_X25519WRAPPER_H
+#define DEFENSIVE_MAMAN_15_X25519WRAPPER_H
+
+#include "cryptopp/xed25519.h"
+#include "AESWrapper.h"
+
+#include <string>
+
+
+// An X25519 identity, used instead of RSA when the server supports it. The server wraps the AES key ECIES style:
+// it agrees on a secret between a fresh ephemeral key and the client's public key, derives a key encryption key and
+// nonce from it using HKDF-SHA256 (salt = ephemeral public key || client public key) and seals the AES key with
+// AES-GCM. The wrapped key is laid out as ephemeral public key || sealed AES key || GCM tag.
+class X25519Wrapper
+{
+public:
+    static const unsigned int KEY_LENGTH = 32;
+    static const unsigned int WRAPPED_KEY_LENGTH = KEY_LENGTH + AESWrapper::DEFAULT_KEYLENGTH + AESWrapper::GCM_TAG_LENGTH;
+
+private:
+    CryptoPP::x25519 _x25519;
+    CryptoPP::byte _privateKey[KEY_LENGTH];
+    CryptoPP::byte _publicKey[KEY_LENGTH];
+
+    X25519Wrapper(const X25519Wrapper& x25519);
+    X25519Wrapper& operator=(const X25519Wrapper& x25519);
+    static void deriveWrapKey(const CryptoPP::byte* secret, const CryptoPP::byte* ephemeralKey,
+                              const CryptoPP::byte* clientKey, CryptoPP::byte* derived);
+public:
+    X25519Wrapper();
+    X25519Wrapper(const std::string& key);
+    ~X25519Wrapper();
+
+    std::string getPrivateKey() const;
+    std::string getPublicKey() const;
+
+    std::string unwrap(const std::string& wrapped) const;
+    // The server's side of the exchange - used by the stand-in server the tests run against
+    static std::string wrap(const std::string& publicKey, const std::string& aesKey);
+};
+
+
+
+#endif
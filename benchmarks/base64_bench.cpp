@@ -0,0 +1,87 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Compare Base64Wrapper's codec with the Crypto++ filter chain it replaced (StringSource -> Base64Encoder
+ * -> StringSink, whose line breaks saveMeInfo then stripped), on large buffers and on a key sized input.
+ * Usage: base64_bench [passes over 1 MiB, default 200]
+ */
+#include "Base64Wrapper.h"
+#include "cryptopp/base64.h"
+#include "cryptopp/filters.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+std::string filterChainEncode(const std::string& plain) {
+    std::string encoded;
+    CryptoPP::StringSource source(plain, true, new CryptoPP::Base64Encoder(new CryptoPP::StringSink(encoded)));
+    encoded.erase(std::remove(encoded.begin(), encoded.end(), '\n'), encoded.end());
+    return encoded;
+}
+
+std::string filterChainDecode(const std::string& encoded) {
+    std::string decoded;
+    CryptoPP::StringSource source(encoded, true, new CryptoPP::Base64Decoder(new CryptoPP::StringSink(decoded)));
+    return decoded;
+}
+
+/**
+ * Runs an operation the given number of times, and reports its throughput and average cost per call.
+ * @param name The operation's name.
+ * @param calls The number of times to run it.
+ * @param bytes The number of plain bytes each call handles.
+ * @param operation The operation, returning the size of its output so it can't be optimized away.
+ * @return The sum of the sizes the operation returned.
+ */
+template <typename Operation>
+size_t measure(const char* name, size_t calls, size_t bytes, Operation operation) {
+    size_t result = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        result += operation();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(28) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << static_cast<double>(bytes * calls) / 1e9 / seconds << " GB/s"
+              << std::setprecision(0) << std::setw(12) << seconds * 1e9 / static_cast<double>(calls) << " ns per call"
+              << std::endl;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t passes = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 200;
+    std::string buffer(size_t(1) << 20, '\0');
+    uint32_t seed = 1;
+    for (char& c : buffer) {
+        seed = seed * 1103515245 + 12345;
+        c = static_cast<char>(seed >> 16);
+    }
+    std::string encodedBuffer = Base64Wrapper::encode(buffer);
+    std::string key = buffer.substr(0, 634);  // The size of a serialized 1024 bit RSA private key
+    std::string encodedKey = Base64Wrapper::encode(key);
+
+    std::cout << "Base64Wrapper backend: " << Base64Wrapper::backendName() << std::endl;
+    size_t results = 0;
+    results += measure("filter chain encode 1 MiB", passes, buffer.size(),
+                       [&]() { return filterChainEncode(buffer).size(); });
+    results += measure("Base64Wrapper encode 1 MiB", passes, buffer.size(),
+                       [&]() { return Base64Wrapper::encode(buffer).size(); });
+    results += measure("filter chain decode 1 MiB", passes, buffer.size(),
+                       [&]() { return filterChainDecode(encodedBuffer).size(); });
+    results += measure("Base64Wrapper decode 1 MiB", passes, buffer.size(),
+                       [&]() { return Base64Wrapper::decode(encodedBuffer).size(); });
+
+    size_t keyCalls = passes * 1000;
+    results += measure("filter chain key round trip", keyCalls, key.size(),
+                       [&]() { return filterChainDecode(filterChainEncode(key)).size(); });
+    results += measure("Base64Wrapper key round trip", keyCalls, key.size(),
+                       [&]() { return Base64Wrapper::decode(Base64Wrapper::encode(key)).size(); });
+    results += measure("Base64Wrapper key decode", keyCalls, key.size(),
+                       [&]() { return Base64Wrapper::decode(encodedKey).size(); });
+    volatile size_t sink = results;  // Keeps the measured work observable
+    (void)sink;
+    return 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Compare the throughput of the byte-wise, sliced and dispatched CRC kernels over multi-GB inputs.
+ * Usage: crc_bench [gigabytes, default 4]
+ */
+#include "checksum.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+
+using CrcFunction = unsigned long (*)(char*, size_t);
+
+/**
+ * Runs a CRC function over the buffer until the requested number of bytes was checksummed, and reports its throughput.
+ * @param name The kernel's name.
+ * @param crc The CRC function to measure.
+ * @param buffer The input, checksummed over and over.
+ * @param totalBytes The number of bytes to checksum in all.
+ * @return The XOR of all the values calculated, so the work can't be optimized away.
+ */
+unsigned long measure(const char* name, CrcFunction crc, std::vector<char>& buffer, uint64_t totalBytes) {
+    unsigned long result = 0;
+    uint64_t done = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (done < totalBytes) {
+        size_t length = static_cast<size_t>(std::min<uint64_t>(buffer.size(), totalBytes - done));
+        result ^= crc(buffer.data(), length);
+        done += length;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(20) << name << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << done / 1e9 / seconds << " GB/s" << std::endl;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    double gigabytes = argc > 1 ? std::strtod(argv[1], nullptr) : 4;
+    auto totalBytes = static_cast<uint64_t>(gigabytes * (uint64_t(1) << 30));
+    std::vector<char> buffer(size_t(64) << 20);
+    uint32_t seed = 1;
+    for (char& c : buffer) {
+        seed = seed * 1103515245 + 12345;
+        c = static_cast<char>(seed >> 16);
+    }
+
+    std::cout << "Checksumming " << gigabytes << " GB per kernel, dispatched backend: " << crcBackendName()
+              << std::endl;
+    unsigned long results = 0;
+    // The byte-wise loop runs over a tenth of the input, it would take minutes otherwise
+    results ^= measure("bytewise", [](char* b, size_t n) { return memcrcBytewise(b, n); }, buffer, totalBytes / 10);
+    results ^= measure("slice8", [](char* b, size_t n) { return memcrcSlice8(b, n); }, buffer, totalBytes);
+    results ^= measure("slice16", [](char* b, size_t n) { return memcrcSlice16(b, n); }, buffer, totalBytes);
+    results ^= measure(crcBackendName(), memcrc, buffer, totalBytes);
+    volatile unsigned long sink = results;  // Keeps the measured work observable
+    (void)sink;
+    return 0;
+}
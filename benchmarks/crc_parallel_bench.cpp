@@ -0,0 +1,59 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Measure how the parallel file CRC scales from one thread up to every core, on a file of the given size.
+ * The file is read once before measuring, so the timings reflect the CRC rather than the disk.
+ * Usage: crc_parallel_bench [gigabytes, default 4] [file, default a temporary file removed afterwards]
+ */
+#include "checksum.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    double gigabytes = argc > 1 ? std::strtod(argv[1], nullptr) : 4;
+    auto size = static_cast<uint64_t>(gigabytes * (uint64_t(1) << 30));
+    bool temporary = argc <= 2;
+    std::string path = temporary ? (std::filesystem::temp_directory_path() / "crc_parallel_bench.bin").string()
+                                 : std::string(argv[2]);
+
+    if (temporary) {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        std::vector<char> chunk(CRC_READ_CHUNK_SIZE);
+        uint32_t seed = 1;
+        for (uint64_t written = 0; written < size && file; written += chunk.size()) {
+            for (char& c : chunk) {
+                seed = seed * 1103515245 + 12345;
+                c = static_cast<char>(seed >> 16);
+            }
+            file.write(chunk.data(), static_cast<std::streamsize>(std::min<uint64_t>(chunk.size(), size - written)));
+        }
+        if (!file) {
+            std::cerr << "Failed writing " << path << std::endl;
+            return 1;
+        }
+    }
+    size = std::filesystem::file_size(path);
+
+    std::cout << "Checksumming " << size / 1e9 << " GB with the " << crcBackendName() << " backend" << std::endl;
+    uint32_t expected = readCrcParallel(path, 1);  // Warms the page cache
+    double serialSeconds = 0;
+    bool mismatch = false;
+    for (unsigned int threads = 1; threads <= ThreadPool::defaultThreadCount(); ++threads) {
+        auto start = std::chrono::steady_clock::now();
+        uint32_t crc = readCrcParallel(path, threads);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        serialSeconds = threads == 1 ? seconds : serialSeconds;
+        mismatch = mismatch || crc != expected;
+        std::cout << std::setw(3) << threads << " threads: " << std::fixed << std::setprecision(2) << std::setw(7)
+                  << size / 1e9 / seconds << " GB/s, speedup " << serialSeconds / seconds
+                  << (crc == expected ? "" : " - CRC MISMATCH") << std::endl;
+    }
+
+    if (temporary) {
+        std::filesystem::remove(path);
+    }
+    return mismatch ? 1 : 0;
+}
@@ -0,0 +1,64 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Measure the aggregate throughput of ParallelUploader against an in-process stand-in server, as the number
+ * of concurrent sessions grows from 1 to the given maximum.
+ * Usage: parallel_upload_bench [files, default 16] [megabytes per file, default 16] [max sessions, default 8]
+ */
+#include "StandInServer.h"
+#include "ParallelUploader.h"
+#include "FileHandler.h"
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+int main(int argc, char* argv[]) {
+    size_t fileCount = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 16;
+    size_t fileSize = (argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 16) << 20;
+    unsigned int maxSessions = argc > 3 ? static_cast<unsigned int>(std::strtoul(argv[3], nullptr, 10)) : 8;
+
+    std::vector<std::string> filePaths;
+    std::vector<char> block(size_t(1) << 20);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < fileCount; ++i) {
+        filePaths.push_back((std::filesystem::temp_directory_path() /
+                             ("parallel_upload_bench_" + std::to_string(i) + ".bin")).string());
+        std::ofstream file(filePaths.back(), std::ios::binary);
+        for (size_t written = 0; written < fileSize; written += block.size()) {
+            for (char& c : block) {
+                seed = seed * 1103515245 + 12345;
+                c = static_cast<char>(seed >> 16);
+            }
+            file.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), fileSize - written)));
+        }
+    }
+
+    // A fresh server knows no client, so the first run registers one and every run after it reconnects
+    std::filesystem::remove(std::string(CLIENTS_BASE_PATH) + ME_INFO_FILE_NAME);
+    StandInServer server(StandInServer::Options{SEGMENTED_GCM_PROTOCOL_VERSION, 0});
+    TransferInfo transferInfo{"127.0.0.1", server.port(), "parallel_upload_bench", filePaths};
+    ParallelUploader(transferInfo, 1).run(false);
+
+    // The uploads log as they go, so the results are reported once all the runs are done
+    std::vector<std::pair<unsigned int, double>> results;
+    for (unsigned int sessions = 1; sessions <= maxSessions; ++sessions) {
+        auto start = std::chrono::steady_clock::now();
+        bool status = ParallelUploader(transferInfo, sessions).run(false);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        results.emplace_back(sessions, status ? static_cast<double>(fileCount * fileSize) / 1e6 / seconds : 0);
+    }
+
+    std::cerr << "Uploading " << fileCount << " files of " << (fileSize >> 20) << " MB" << std::endl;
+    for (const auto& [sessions, throughput] : results) {
+        std::cerr << std::setw(3) << sessions << " sessions" << std::fixed << std::setprecision(1) << std::setw(10)
+                  << throughput << " MB/s" << (throughput == 0 ? "  (failed)" : "") << std::endl;
+    }
+    for (const std::string& filePath : filePaths) {
+        std::filesystem::remove(filePath);
+    }
+    return 0;
+}
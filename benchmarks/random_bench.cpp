@@ -0,0 +1,61 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Measure what generating an IV costs every encrypt call - a freshly seeded AutoSeededRandomPool, as
+ * AESWrapper::encrypt used to create, against a draw from RandomService's per-thread batch - and the cost of a whole
+ * small AESWrapper::encrypt call for scale.
+ * Usage: random_bench [calls, default 100000]
+ */
+#include "AESWrapper.h"
+#include "RandomService.h"
+#include "cryptopp/osrng.h"
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+
+/**
+ * Runs an operation the given number of times, and reports its average cost per call.
+ * @param name The operation's name.
+ * @param calls The number of times to run it.
+ * @param operation The operation, returning a byte of its output so it can't be optimized away.
+ * @return The XOR of the bytes the operation returned.
+ */
+template <typename Operation>
+unsigned char measure(const char* name, size_t calls, Operation operation) {
+    unsigned char result = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < calls; ++i) {
+        result ^= operation();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << std::left << std::setw(32) << name << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << seconds * 1e9 / static_cast<double>(calls) << " ns per call" << std::endl;
+    return result;
+}
+
+int main(int argc, char* argv[]) {
+    size_t calls = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100000;
+    unsigned char iv[CryptoPP::AES::BLOCKSIZE];
+    unsigned char results = 0;
+
+    // The pool is reseeded from the OS on every construction, so it gets fewer calls
+    results ^= measure("AutoSeededRandomPool per call", calls / 10, [&iv]() {
+        CryptoPP::AutoSeededRandomPool rng;
+        rng.GenerateBlock(iv, sizeof(iv));
+        return iv[0];
+    });
+    results ^= measure("RandomService::generate", calls, [&iv]() {
+        RandomService::generate(iv, sizeof(iv));
+        return iv[0];
+    });
+
+    AESWrapper aes;
+    const char message[64] = "A short message, about the size of a file name or a key";
+    results ^= measure("AESWrapper::encrypt (64 bytes)", calls, [&aes, &message]() {
+        return static_cast<unsigned char>(aes.encrypt(message, sizeof(message))[0]);
+    });
+    volatile unsigned char sink = results;  // Keeps the measured work observable
+    (void)sink;
+    return 0;
+}
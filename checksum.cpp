@@ -6,6 +6,15 @@
 #include <iterator>
 #include <filesystem>
 #include <string>
+#include <algorithm>
+#include <stdexcept>
+#include "checksum.h"
+#include "ThreadPool.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
 
 
 uint_fast32_t const crctab[8][256] = {
@@ -445,23 +454,532 @@ uint_fast32_t const crctab[8][256] = {
 
 #define UNSIGNED(n) (n & 0xffffffff)
 
-unsigned long memcrc(char * b, size_t n) {
-    unsigned int v = 0, c = 0;
-    unsigned long s = 0;
-    unsigned int tabidx;
+namespace {
+
+/**
+ * Builds the slicing tables 8..15 that extend crctab for the slicing-by-16 kernel. Entry [k][i] holds the CRC
+ * register contribution of byte i followed by (k + 8) zero bytes.
+ */
+struct CrcHighSlices {
+    uint32_t table[8][256];
+
+    constexpr CrcHighSlices() : table() {
+        uint32_t slices[16][256] = {};
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t c = i << 24;
+            for (int bit = 0; bit < 8; ++bit) {
+                c = (c & 0x80000000) ? (c << 1) ^ 0x04c11db7 : (c << 1);
+            }
+            slices[0][i] = c;
+        }
+        for (int k = 1; k < 16; ++k) {
+            for (int i = 0; i < 256; ++i) {
+                uint32_t prev = slices[k - 1][i];
+                slices[k][i] = (prev << 8) ^ slices[0][prev >> 24];
+            }
+        }
+        for (int k = 0; k < 8; ++k) {
+            for (int i = 0; i < 256; ++i) {
+                table[k][i] = slices[k + 8][i];
+            }
+        }
+    }
+};
+
+constexpr CrcHighSlices crctabHigh;
 
-    for (int i = 0; i < n; i++) {
-        tabidx = (s >> 24) ^ (unsigned char)b[i];
-        s = UNSIGNED((s << 8)) ^ crctab[0][tabidx];
+inline uint32_t loadBigEndian32(const unsigned char* p) {
+    return (uint32_t(p[0]) << 24) | (uint32_t(p[1]) << 16) | (uint32_t(p[2]) << 8) | uint32_t(p[3]);
+}
+
+/**
+ * Feeds bytes into the CRC register one at a time - this is the original cksum loop and serves as the reference
+ * implementation for the sliced kernels.
+ */
+uint32_t crcBytewise(uint32_t s, const unsigned char* b, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        s = UNSIGNED((s << 8)) ^ crctab[0][(s >> 24) ^ b[i]];
+    }
+    return s;
+}
+
+/**
+ * Feeds bytes into the CRC register 8 at a time using crctab[0..7].
+ */
+uint32_t crcSlice8(uint32_t s, const unsigned char* b, size_t n) {
+    while (n >= 8) {
+        uint32_t hi = s ^ loadBigEndian32(b);
+        s = crctab[7][hi >> 24] ^ crctab[6][(hi >> 16) & 0xff] ^
+            crctab[5][(hi >> 8) & 0xff] ^ crctab[4][hi & 0xff] ^
+            crctab[3][b[4]] ^ crctab[2][b[5]] ^ crctab[1][b[6]] ^ crctab[0][b[7]];
+        b += 8;
+        n -= 8;
+    }
+    return crcBytewise(s, b, n);
+}
+
+/**
+ * Feeds bytes into the CRC register 16 at a time using crctab[0..7] and the generated slices 8..15.
+ */
+uint32_t crcSlice16(uint32_t s, const unsigned char* b, size_t n) {
+    const auto& high = crctabHigh.table;
+    while (n >= 16) {
+        uint32_t hi = s ^ loadBigEndian32(b);
+        s = high[7][hi >> 24] ^ high[6][(hi >> 16) & 0xff] ^
+            high[5][(hi >> 8) & 0xff] ^ high[4][hi & 0xff] ^
+            high[3][b[4]] ^ high[2][b[5]] ^ high[1][b[6]] ^ high[0][b[7]] ^
+            crctab[7][b[8]] ^ crctab[6][b[9]] ^ crctab[5][b[10]] ^ crctab[4][b[11]] ^
+            crctab[3][b[12]] ^ crctab[2][b[13]] ^ crctab[1][b[14]] ^ crctab[0][b[15]];
+        b += 16;
+        n -= 16;
     }
+    return crcSlice8(s, b, n);
+}
 
+/**
+ * Mixes the message length into the CRC register (least significant byte first) and returns the cksum value.
+ */
+uint32_t crcFinish(uint32_t s, uint64_t n) {
     while (n) {
-        c = n & 0377;
+        unsigned int c = n & 0377;
         n = n >> 8;
         s = UNSIGNED(s << 8) ^ crctab[0][(s >> 24) ^ c];
     }
-    return (unsigned long)UNSIGNED(~s);
+    return UNSIGNED(~s);
+}
+
+
+/**
+ * Computes x^n mod P for the cksum polynomial, used to derive the carry-less multiplication folding constants.
+ */
+constexpr uint64_t xPowModP(unsigned int n) {
+    uint32_t r = 1;
+    for (unsigned int i = 0; i < n; ++i) {
+        r = (r & 0x80000000) ? (r << 1) ^ 0x04c11db7 : (r << 1);
+    }
+    return r;
+}
+
+/**
+ * Multiplies two polynomials modulo the cksum polynomial P (both in the non-reflected, MSB-first representation).
+ */
+constexpr uint32_t gf2MulModP(uint32_t a, uint32_t b) {
+    uint32_t product = 0;
+    for (int bit = 31; bit >= 0; --bit) {
+        product = (product & 0x80000000) ? (product << 1) ^ 0x04c11db7 : (product << 1);
+        if (b & (1u << bit)) {
+            product ^= a;
+        }
+    }
+    return product;
+}
+
+/**
+ * Holds x^(8 * 2^k) mod P for k = 0..63, so shifting a CRC register over any number of zero bytes takes at most 64
+ * multiplications.
+ */
+struct ZeroBytePowers {
+    uint32_t power[64];
+
+    constexpr ZeroBytePowers() : power() {
+        power[0] = static_cast<uint32_t>(xPowModP(8));
+        for (int k = 1; k < 64; ++k) {
+            power[k] = gf2MulModP(power[k - 1], power[k - 1]);
+        }
+    }
+};
+
+constexpr ZeroBytePowers zeroBytePowers;
+
+/**
+ * Advances a CRC register as if n zero bytes had been fed into it.
+ */
+uint32_t crcShiftZeroBytes(uint32_t s, uint64_t n) {
+    for (int k = 0; n != 0 && s != 0; ++k, n >>= 1) {
+        if (n & 1) {
+            s = gf2MulModP(s, zeroBytePowers.power[k]);
+        }
+    }
+    return s;
+}
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CRC_HAVE_CLMUL 1
+
+// Folding a 128-bit lane X = hi * x^64 + lo forward by D bits multiplies hi by x^(D+64) mod P and lo by x^D mod P.
+constexpr uint64_t FOLD_128_HI = xPowModP(128 + 64), FOLD_128_LO = xPowModP(128);
+constexpr uint64_t FOLD_512_HI = xPowModP(512 + 64), FOLD_512_LO = xPowModP(512);
+constexpr uint64_t FOLD_1024_HI = xPowModP(1024 + 64), FOLD_1024_LO = xPowModP(1024);
+constexpr uint64_t FOLD_2048_HI = xPowModP(2048 + 64), FOLD_2048_LO = xPowModP(2048);
+
+/**
+ * Feeds the 128-bit fold remainder back through the table kernel. The remainder is congruent to every byte folded so
+ * far, so its 16 bytes (most significant first) produce the same CRC register as the original prefix.
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint32_t crcFoldFinish(__m128i x, const __m128i& reverse, const unsigned char* b, size_t n) {
+    alignas(16) unsigned char remainder[16];
+    _mm_store_si128(reinterpret_cast<__m128i*>(remainder), _mm_shuffle_epi8(x, reverse));
+    return crcSlice16(crcSlice16(0, remainder, sizeof(remainder)), b, n);
+}
+
+// Loads 16 message bytes so that the first byte lands in the most significant position of the lane.
+__attribute__((target("pclmul,sse4.1")))
+inline __m128i loadReversed128(const unsigned char* p, __m128i reverse) {
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)), reverse);
+}
+
+__attribute__((target("pclmul,sse4.1")))
+inline __m128i fold128(__m128i x, __m128i k) {
+    return _mm_xor_si128(_mm_clmulepi64_si128(x, k, 0x01), _mm_clmulepi64_si128(x, k, 0x10));
+}
+
+/**
+ * Folds 64 bytes per step with PCLMULQDQ across four 128-bit accumulators.
+ */
+__attribute__((target("pclmul,sse4.1")))
+uint32_t crcPclmul(uint32_t s, const unsigned char* b, size_t n) {
+    if (n < 64) {
+        return crcSlice16(s, b, n);
+    }
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i k512 = _mm_set_epi64x(FOLD_512_LO, FOLD_512_HI);
+    const __m128i k128 = _mm_set_epi64x(FOLD_128_LO, FOLD_128_HI);
+
+    // The incoming register is equivalent to XOR-ing it into the first four message bytes.
+    __m128i x0 = _mm_xor_si128(loadReversed128(b, reverse), _mm_set_epi32(static_cast<int>(s), 0, 0, 0));
+    __m128i x1 = loadReversed128(b + 16, reverse), x2 = loadReversed128(b + 32, reverse), x3 = loadReversed128(b + 48, reverse);
+    b += 64;
+    n -= 64;
+
+    while (n >= 64) {
+        x0 = _mm_xor_si128(fold128(x0, k512), loadReversed128(b, reverse));
+        x1 = _mm_xor_si128(fold128(x1, k512), loadReversed128(b + 16, reverse));
+        x2 = _mm_xor_si128(fold128(x2, k512), loadReversed128(b + 32, reverse));
+        x3 = _mm_xor_si128(fold128(x3, k512), loadReversed128(b + 48, reverse));
+        b += 64;
+        n -= 64;
+    }
+
+    __m128i x = _mm_xor_si128(fold128(x0, k128), x1);
+    x = _mm_xor_si128(fold128(x, k128), x2);
+    x = _mm_xor_si128(fold128(x, k128), x3);
+    while (n >= 16) {
+        x = _mm_xor_si128(fold128(x, k128), loadReversed128(b, reverse));
+        b += 16;
+        n -= 16;
+    }
+    return crcFoldFinish(x, reverse, b, n);
+}
+
+__attribute__((target("avx2,vpclmulqdq,pclmul,sse4.1")))
+inline __m256i loadReversed256(const unsigned char* p, __m256i reverse) {
+    return _mm256_shuffle_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)), reverse);
+}
 
+__attribute__((target("avx2,vpclmulqdq,pclmul,sse4.1")))
+inline __m256i fold256(__m256i x, __m256i k) {
+    return _mm256_xor_si256(_mm256_clmulepi64_epi128(x, k, 0x01), _mm256_clmulepi64_epi128(x, k, 0x10));
+}
+
+/**
+ * Folds 128 bytes per step with VPCLMULQDQ across four 256-bit accumulators (AVX2 hosts without AVX-512).
+ */
+__attribute__((target("avx2,vpclmulqdq,pclmul,sse4.1")))
+uint32_t crcVpclmulAvx2(uint32_t s, const unsigned char* b, size_t n) {
+    if (n < 128) {
+        return crcPclmul(s, b, n);
+    }
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m256i reverse256 = _mm256_broadcastsi128_si256(reverse);
+    const __m256i k1024 = _mm256_broadcastsi128_si256(_mm_set_epi64x(FOLD_1024_LO, FOLD_1024_HI));
+    const __m256i k256 = _mm256_broadcastsi128_si256(_mm_set_epi64x(xPowModP(256), xPowModP(256 + 64)));
+    const __m128i k128 = _mm_set_epi64x(FOLD_128_LO, FOLD_128_HI);
+
+    __m256i x0 = _mm256_xor_si256(loadReversed256(b, reverse256), _mm256_set_epi32(0, 0, 0, 0, static_cast<int>(s), 0, 0, 0));
+    __m256i x1 = loadReversed256(b + 32, reverse256), x2 = loadReversed256(b + 64, reverse256), x3 = loadReversed256(b + 96, reverse256);
+    b += 128;
+    n -= 128;
+
+    while (n >= 128) {
+        x0 = _mm256_xor_si256(fold256(x0, k1024), loadReversed256(b, reverse256));
+        x1 = _mm256_xor_si256(fold256(x1, k1024), loadReversed256(b + 32, reverse256));
+        x2 = _mm256_xor_si256(fold256(x2, k1024), loadReversed256(b + 64, reverse256));
+        x3 = _mm256_xor_si256(fold256(x3, k1024), loadReversed256(b + 96, reverse256));
+        b += 128;
+        n -= 128;
+    }
+
+    __m256i y = _mm256_xor_si256(fold256(x0, k256), x1);
+    y = _mm256_xor_si256(fold256(y, k256), x2);
+    y = _mm256_xor_si256(fold256(y, k256), x3);
+    __m128i x = _mm_xor_si128(fold128(_mm256_castsi256_si128(y), k128), _mm256_extracti128_si256(y, 1));
+    while (n >= 16) {
+        x = _mm_xor_si128(fold128(x, k128), loadReversed128(b, reverse));
+        b += 16;
+        n -= 16;
+    }
+    return crcFoldFinish(x, reverse, b, n);
+}
+
+__attribute__((target("avx512f,avx512bw,vpclmulqdq,pclmul,sse4.1")))
+inline __m512i loadReversed512(const unsigned char* p, __m512i reverse) {
+    return _mm512_shuffle_epi8(_mm512_loadu_si512(p), reverse);
+}
+
+__attribute__((target("avx512f,avx512bw,vpclmulqdq,pclmul,sse4.1")))
+inline __m512i fold512(__m512i x, __m512i k) {
+    return _mm512_xor_si512(_mm512_clmulepi64_epi128(x, k, 0x01), _mm512_clmulepi64_epi128(x, k, 0x10));
+}
+
+/**
+ * Folds 256 bytes per step with VPCLMULQDQ across four 512-bit accumulators.
+ */
+__attribute__((target("avx512f,avx512bw,vpclmulqdq,pclmul,sse4.1")))
+uint32_t crcVpclmulAvx512(uint32_t s, const unsigned char* b, size_t n) {
+    if (n < 256) {
+        return crcPclmul(s, b, n);
+    }
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m512i reverse512 = _mm512_broadcast_i32x4(reverse);
+    const __m512i k2048 = _mm512_broadcast_i32x4(_mm_set_epi64x(FOLD_2048_LO, FOLD_2048_HI));
+    const __m512i k512 = _mm512_broadcast_i32x4(_mm_set_epi64x(FOLD_512_LO, FOLD_512_HI));
+    const __m128i k128 = _mm_set_epi64x(FOLD_128_LO, FOLD_128_HI);
+
+    __m512i x0 = _mm512_xor_si512(loadReversed512(b, reverse512), _mm512_zextsi128_si512(_mm_set_epi32(static_cast<int>(s), 0, 0, 0)));
+    __m512i x1 = loadReversed512(b + 64, reverse512), x2 = loadReversed512(b + 128, reverse512), x3 = loadReversed512(b + 192, reverse512);
+    b += 256;
+    n -= 256;
+
+    while (n >= 256) {
+        x0 = _mm512_xor_si512(fold512(x0, k2048), loadReversed512(b, reverse512));
+        x1 = _mm512_xor_si512(fold512(x1, k2048), loadReversed512(b + 64, reverse512));
+        x2 = _mm512_xor_si512(fold512(x2, k2048), loadReversed512(b + 128, reverse512));
+        x3 = _mm512_xor_si512(fold512(x3, k2048), loadReversed512(b + 192, reverse512));
+        b += 256;
+        n -= 256;
+    }
+
+    __m512i y = _mm512_xor_si512(fold512(x0, k512), x1);
+    y = _mm512_xor_si512(fold512(y, k512), x2);
+    y = _mm512_xor_si512(fold512(y, k512), x3);
+    while (n >= 64) {
+        y = _mm512_xor_si512(fold512(y, k512), loadReversed512(b, reverse512));
+        b += 64;
+        n -= 64;
+    }
+
+    __m128i x = _mm512_castsi512_si128(y);
+    x = _mm_xor_si128(fold128(x, k128), _mm512_extracti32x4_epi32(y, 1));
+    x = _mm_xor_si128(fold128(x, k128), _mm512_extracti32x4_epi32(y, 2));
+    x = _mm_xor_si128(fold128(x, k128), _mm512_extracti32x4_epi32(y, 3));
+    while (n >= 16) {
+        x = _mm_xor_si128(fold128(x, k128), loadReversed128(b, reverse));
+        b += 16;
+        n -= 16;
+    }
+    return crcFoldFinish(x, reverse, b, n);
+}
+
+/**
+ * Queries cpuid (and xgetbv for OS-enabled vector state) for the instruction set extensions the folding kernels need.
+ */
+struct CpuFeatures {
+    bool pclmul = false;
+    bool vpclmulAvx2 = false;
+    bool vpclmulAvx512 = false;
+
+    CpuFeatures() {
+        unsigned int eax, ebx, ecx, edx;
+        if (!__get_cpuid(1, &eax, &ebx, &ecx, &edx)) {
+            return;
+        }
+        bool ssse3 = ecx & (1u << 9), sse41 = ecx & (1u << 19), osxsave = ecx & (1u << 27), avx = ecx & (1u << 28);
+        pclmul = (ecx & (1u << 1)) && ssse3 && sse41;
+        if (!pclmul || !osxsave || !avx || !__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx)) {
+            return;
+        }
+        bool avx2 = ebx & (1u << 5), avx512f = ebx & (1u << 16), avx512bw = ebx & (1u << 30);
+        bool vpclmul = ecx & (1u << 10);
+
+        unsigned int xcr0, xcr0High;
+        __asm__("xgetbv" : "=a"(xcr0), "=d"(xcr0High) : "c"(0));
+        bool ymmState = (xcr0 & 0x6) == 0x6;
+        bool zmmState = (xcr0 & 0xe6) == 0xe6;
+
+        vpclmulAvx2 = vpclmul && avx2 && ymmState;
+        vpclmulAvx512 = vpclmul && avx512f && avx512bw && zmmState;
+    }
+};
+#endif
+
+using CrcKernel = uint32_t (*)(uint32_t, const unsigned char*, size_t);
+
+struct CrcBackend {
+    const char* name;
+    CrcKernel kernel;
+};
+
+/**
+ * Lists the CRC kernels this CPU can run, fastest first. The portable table-driven kernel is always last.
+ */
+std::vector<CrcBackend> supportedBackends() {
+    std::vector<CrcBackend> backends;
+#ifdef CRC_HAVE_CLMUL
+    CpuFeatures cpu;
+    if (cpu.vpclmulAvx512) backends.push_back({"vpclmulqdq-avx512", crcVpclmulAvx512});
+    if (cpu.vpclmulAvx2) backends.push_back({"vpclmulqdq-avx2", crcVpclmulAvx2});
+    if (cpu.pclmul) backends.push_back({"pclmulqdq", crcPclmul});
+#endif
+    backends.push_back({"slice16", crcSlice16});
+    return backends;
+}
+
+/**
+ * Checks a kernel against the byte-wise reference loop over every tail length up to a few folding strides and a
+ * handful of unaligned start offsets, so the dispatcher never selects a kernel that disagrees with cksum.
+ */
+bool kernelMatchesReference(CrcKernel kernel) {
+    static const std::vector<unsigned char> sample = [] {
+        std::vector<unsigned char> buffer(2048 + 64);
+        uint32_t seed = 0x12345678;
+        for (unsigned char& c : buffer) {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<unsigned char>(seed >> 16);
+        }
+        return buffer;
+    }();
+
+    for (size_t offset = 0; offset < 4; ++offset) {
+        for (size_t length = 0; length + offset <= sample.size(); length += (length < 320 ? 1 : 37)) {
+            const unsigned char* data = sample.data() + offset;
+            uint32_t seed = static_cast<uint32_t>(length * 0x9e3779b9);
+            if (kernel(seed, data, length) != crcBytewise(seed, data, length)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+/**
+ * Picks the CRC kernel once per process - the fastest backend the CPU supports that passes the reference check.
+ */
+const CrcBackend& activeBackend() {
+    static const CrcBackend backend = [] {
+        for (const CrcBackend& candidate : supportedBackends()) {
+            if (kernelMatchesReference(candidate.kernel)) {
+                return candidate;
+            }
+        }
+        return CrcBackend{"bytewise", crcBytewise};
+    }();
+    return backend;
+}
+
+} // namespace
+
+unsigned long memcrcBytewise(const char * b, size_t n) {
+    return crcFinish(crcBytewise(0, reinterpret_cast<const unsigned char*>(b), n), n);
+}
+
+unsigned long memcrcSlice8(const char * b, size_t n) {
+    return crcFinish(crcSlice8(0, reinterpret_cast<const unsigned char*>(b), n), n);
+}
+
+unsigned long memcrcSlice16(const char * b, size_t n) {
+    return crcFinish(crcSlice16(0, reinterpret_cast<const unsigned char*>(b), n), n);
+}
+
+unsigned long memcrc(char * b, size_t n) {
+    CrcState state = crcInit();
+    crcUpdate(state, b, n);
+    return crcFinalize(state);
+}
+
+/**
+ * Creates an empty CRC state, ready to be fed with crcUpdate.
+ * @return A CRC state representing a zero-length message.
+ */
+CrcState crcInit() {
+    return CrcState{0, 0};
+}
+
+/**
+ * Feeds the next chunk of a message into a CRC state. Chunks may be of any size and split at any offset.
+ * @param state The CRC state to update.
+ * @param data The chunk to feed.
+ * @param n The size of the chunk in bytes.
+ */
+void crcUpdate(CrcState& state, const char* data, size_t n) {
+    state.crc = activeBackend().kernel(state.crc, reinterpret_cast<const unsigned char*>(data), n);
+    state.length += n;
+}
+
+/**
+ * Produces the cksum value of everything fed into a CRC state so far. The state itself is left untouched, so more
+ * data can still be fed into it afterwards.
+ * @param state The CRC state to finalize.
+ * @return The POSIX cksum value of the message.
+ */
+uint32_t crcFinalize(const CrcState& state) {
+    return crcFinish(state.crc, state.length);
+}
+
+/**
+ * Combines the CRC states of two adjacent parts of a message into the state of their concatenation, without touching
+ * the data again. This lets independent readers or threads each checksum a range of the message.
+ * @param first The CRC state of the leading part.
+ * @param second The CRC state of the part that directly follows it.
+ * @return The CRC state of first followed by second.
+ */
+CrcState crcCombine(const CrcState& first, const CrcState& second) {
+    return CrcState{crcShiftZeroBytes(first.crc, second.length) ^ second.crc, first.length + second.length};
+}
+
+/**
+ * Returns the name of the CRC kernel memcrc dispatches to on this CPU.
+ */
+const char* crcBackendName() {
+    return activeBackend().name;
+}
+
+/**
+ * Verifies every CRC kernel this CPU supports (sliced and carry-less multiplication folding) against the byte-wise
+ * reference loop, and checks the well known cksum value of "123456789".
+ * @return True if all kernels agree, false otherwise.
+ */
+bool crcSelfTest() {
+    const char check[] = "123456789";
+    if (memcrcBytewise(check, 9) != 930766865UL) {
+        return false;
+    }
+    if (!kernelMatchesReference(crcSlice8)) {
+        return false;
+    }
+    for (const CrcBackend& backend : supportedBackends()) {
+        if (!kernelMatchesReference(backend.kernel)) {
+            return false;
+        }
+    }
+
+    // Chunked updates and combined partial states must match the one-shot value for every split point.
+    std::vector<char> message(300);
+    for (size_t i = 0; i < message.size(); ++i) {
+        message[i] = static_cast<char>(i * 131 + 7);
+    }
+    uint32_t expected = memcrcBytewise(message.data(), message.size());
+    for (size_t split = 0; split <= message.size(); ++split) {
+        CrcState whole = crcInit(), head = crcInit(), tail = crcInit();
+        crcUpdate(whole, message.data(), split);
+        crcUpdate(whole, message.data() + split, message.size() - split);
+        crcUpdate(head, message.data(), split);
+        crcUpdate(tail, message.data() + split, message.size() - split);
+        if (crcFinalize(whole) != expected || crcFinalize(crcCombine(head, tail)) != expected) {
+            return false;
+        }
+    }
+    return true;
 }
 
 std::string readfile(std::string fname) {
@@ -483,31 +1001,97 @@ std::string readfile(std::string fname) {
     }
 }
 
+namespace {
+
+/**
+ * Calculates the CRC state of a byte range of a file, reading it in fixed-size chunks through its own stream so that
+ * several ranges can be read concurrently.
+ * @throws std::runtime_error If the file cannot be opened or the range cannot be read in full.
+ */
+CrcState crcFileRange(const std::string& fname, uint64_t offset, uint64_t length) {
+    std::ifstream file(fname, std::ios::binary);
+    if (!file || !file.seekg(static_cast<std::streamoff>(offset), std::ios::beg)) {
+        throw std::runtime_error("Cannot open input file " + fname);
+    }
+
+    std::vector<char> buffer(static_cast<size_t>(std::min<uint64_t>(CRC_READ_CHUNK_SIZE, length)));
+    CrcState state = crcInit();
+    while (length > 0) {
+        auto chunk = static_cast<std::streamsize>(std::min<uint64_t>(buffer.size(), length));
+        if (!file.read(buffer.data(), chunk)) {
+            throw std::runtime_error("Error reading file " + fname);
+        }
+        crcUpdate(state, buffer.data(), static_cast<size_t>(chunk));
+        length -= static_cast<uint64_t>(chunk);
+    }
+    return state;
+}
+
+} // namespace
+
 /**
- * Reads the contents of a file and calculates its CRC value.
+ * Reads the contents of a file and calculates its CRC value. Large files are checksummed in parallel ranges (see
+ * readCrcParallel), smaller ones are streamed through a single CRC state in fixed-size chunks, so the file never has
+ * to fit in memory as a whole.
  * @param fname The name of the file to read and calculate the CRC for.
  * @return The calculated CRC value of the file's contents or 0 if an error occurred.
  */
 uint32_t readCrc(const std::string& fname) {
-    std::ifstream file(fname, std::ios::binary | std::ios::ate);
-    if (!file) {
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(fname, error);
+    if (error) {
         std::cerr << "Cannot open input file " << fname << std::endl;
         return 0;
     }
+    if (size >= CRC_PARALLEL_MIN_SIZE && ThreadPool::defaultThreadCount() > 1) {
+        return readCrcParallel(fname, ThreadPool::defaultThreadCount());
+    }
 
-    std::streamsize size = file.tellg();
-    if (size == -1) {
-        std::cerr << "Error determining the size of the file " << fname << std::endl;
+    try {
+        return crcFinalize(crcFileRange(fname, 0, size));
+    } catch (const std::runtime_error& e) {
+        std::cerr << e.what() << std::endl;
         return 0;
     }
+}
 
-    std::vector<char> buffer(size);
-    file.seekg(0, std::ios::beg);
-    if (!file.read(buffer.data(), size)) {
-        std::cerr << "Error reading file " << fname << std::endl;
+/**
+ * Calculates the CRC value of a file by splitting it into ranges, checksumming the ranges on a thread pool and
+ * merging the partial CRC states in order with crcCombine. The result is identical to the serial value.
+ * @param fname The name of the file to read and calculate the CRC for.
+ * @param threadCount The number of worker threads to use.
+ * @return The calculated CRC value of the file's contents or 0 if an error occurred.
+ */
+uint32_t readCrcParallel(const std::string& fname, unsigned int threadCount) {
+    std::error_code error;
+    uint64_t size = std::filesystem::file_size(fname, error);
+    if (error) {
+        std::cerr << "Cannot open input file " << fname << std::endl;
         return 0;
     }
 
-    uint32_t crcValue = memcrc(buffer.data(), size);
-    return crcValue;
+    // A few ranges per worker keeps the workers busy when some ranges read slower than others.
+    ThreadPool pool(threadCount);
+    uint64_t rangeCount = std::max<uint64_t>(1, std::min<uint64_t>(uint64_t(pool.size()) * 4, size / CRC_PARALLEL_MIN_RANGE));
+    uint64_t rangeSize = (size + rangeCount - 1) / rangeCount;
+
+    std::vector<std::future<CrcState>> partials;
+    for (uint64_t offset = 0; offset < size || partials.empty(); offset += rangeSize) {
+        uint64_t length = std::min(rangeSize, size - offset);
+        partials.push_back(pool.submit([&fname, offset, length]() { return crcFileRange(fname, offset, length); }));
+    }
+
+    CrcState state = crcInit();
+    bool failed = false;
+    for (std::future<CrcState>& partial : partials) {
+        try {
+            state = crcCombine(state, partial.get());
+        } catch (const std::runtime_error& e) {
+            if (!failed) {
+                std::cerr << e.what() << std::endl;
+            }
+            failed = true;
+        }
+    }
+    return failed ? 0 : crcFinalize(state);
 }
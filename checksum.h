@@ -17,9 +17,35 @@
 
 extern uint_fast32_t const crctab[8][256];
 
+// Chunk size used when streaming a file through the CRC.
+constexpr size_t CRC_READ_CHUNK_SIZE = 1 << 20;
+// Files at least this large are checksummed in parallel ranges, each range being at least CRC_PARALLEL_MIN_RANGE.
+constexpr uint64_t CRC_PARALLEL_MIN_SIZE = uint64_t(64) << 20;
+constexpr uint64_t CRC_PARALLEL_MIN_RANGE = uint64_t(16) << 20;
+
+/**
+ * Running CRC of a message that is fed in chunks: the raw CRC register and the number of bytes fed so far (cksum
+ * mixes the total length in only when finalizing).
+ */
+struct CrcState {
+    uint32_t crc;
+    uint64_t length;
+};
+
+CrcState crcInit();
+void crcUpdate(CrcState& state, const char* data, size_t n);
+uint32_t crcFinalize(const CrcState& state);
+CrcState crcCombine(const CrcState& first, const CrcState& second);
+
 unsigned long memcrc(char * b, size_t n);
+unsigned long memcrcBytewise(const char * b, size_t n);
+unsigned long memcrcSlice8(const char * b, size_t n);
+unsigned long memcrcSlice16(const char * b, size_t n);
+bool crcSelfTest();
+const char* crcBackendName();
 std::string readfile(std::string fname);
 uint32_t readCrc(const std::string& fname);
+uint32_t readCrcParallel(const std::string& fname, unsigned int threadCount);
 
 
 #endif //DEFENSIVE_MAMAN_15_CHECKSUM_H
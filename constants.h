@@ -6,11 +6,25 @@
 #define DEFENSIVE_MAMAN_15_CONSTANTS_H
 #include "string"
 
-const char CLIENTS_BASE_PATH[] = "/Users/erez/Desktop/defensive_prog_lab/c++/defensive_maman_15/";
+// The tests build the client with a directory of their own, so they never touch a real client's me.info
+#ifndef CLIENTS_BASE_DIRECTORY
+#define CLIENTS_BASE_DIRECTORY "/Users/erez/Desktop/defensive_prog_lab/c++/defensive_maman_15/"
+#endif
+const char CLIENTS_BASE_PATH[] = CLIENTS_BASE_DIRECTORY;
 const char PROTOCOL_VERSION = '3';
+// Servers reporting at least this version accept SEND_FILE content as raw cipher bytes instead of hex text.
+const char BINARY_CONTENT_PROTOCOL_VERSION = '4';
+// Servers reporting at least this version accept SEND_FILE content as AES-GCM segments (see ContentEncoding).
+const char SEGMENTED_GCM_PROTOCOL_VERSION = '5';
+// Servers reporting at least this version accept an X25519 public key instead of an RSA one (see X25519Wrapper).
+const char X25519_KEY_EXCHANGE_PROTOCOL_VERSION = '6';
+// Servers reporting at least this version accept large files as a multi-part upload (BEGIN / CHUNK / COMMIT).
+const char CHUNKED_UPLOAD_PROTOCOL_VERSION = '7';
 const char PRIVATE_KEY_FILE[] = "priv.key";
 const char ME_INFO_FILE_NAME[] = "me.info";
 const char TRANSFER_INFO_FILE_NAME[] = "transfer.info";
+const char UPLOAD_JOURNAL_PREFIX[] = "upload_";
+const char RSA_KEY_STOCK_FILE[] = "rsa_key_stock";
 
 namespace ServerRequests {
     namespace Codes {
@@ -21,6 +35,11 @@ namespace ServerRequests {
         constexpr uint16_t CRC_CORRECT = 1029;
         constexpr uint16_t CRC_INCORRECT_RESEND = 1030;
         constexpr uint16_t CRC_INCORRECT_DONE = 1031;
+        constexpr uint16_t SEND_X25519_PUBLIC_KEY = 1032;
+        constexpr uint16_t BEGIN_FILE_UPLOAD = 1033;
+        constexpr uint16_t SEND_FILE_CHUNK = 1034;
+        constexpr uint16_t COMMIT_FILE_UPLOAD = 1035;
+        constexpr uint16_t RESUME_FILE_UPLOAD = 1036;
     }
     namespace Consts {
         constexpr uint16_t NAME_FIELD_SIZE = 255;
@@ -0,0 +1,110 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Encode binary data as lowercase hexadecimal straight into a caller provided buffer, using SSSE3 / AVX2
+ * nibble lookups when the CPU supports them.
+ */
+#include "hexencode.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HEX_HAVE_SIMD 1
+#include <immintrin.h>
+#endif
+
+namespace {
+
+const char HEX_DIGITS[] = "0123456789abcdef";
+
+#ifdef HEX_HAVE_SIMD
+/**
+ * Encodes 16 bytes per step: the high and low nibbles are looked up with PSHUFB and interleaved back into order.
+ */
+__attribute__((target("ssse3")))
+void hexEncodeSsse3(const char* in, size_t n, char* out) {
+    const __m128i digits = _mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS));
+    const __m128i lowNibble = _mm_set1_epi8(0x0f);
+    for (; n >= 16; in += 16, out += 32, n -= 16) {
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in));
+        __m128i high = _mm_shuffle_epi8(digits, _mm_and_si128(_mm_srli_epi16(bytes, 4), lowNibble));
+        __m128i low = _mm_shuffle_epi8(digits, _mm_and_si128(bytes, lowNibble));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_unpacklo_epi8(high, low));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out + 16), _mm_unpackhi_epi8(high, low));
+    }
+    hexEncodeScalar(in, n, out);
+}
+
+/**
+ * Encodes 32 bytes per step. The input quadwords are reordered first, so that the in-lane unpack instructions emit
+ * the characters in message order.
+ */
+__attribute__((target("avx2")))
+void hexEncodeAvx2(const char* in, size_t n, char* out) {
+    const __m256i digits = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(HEX_DIGITS)));
+    const __m256i lowNibble = _mm256_set1_epi8(0x0f);
+    for (; n >= 32; in += 32, out += 64, n -= 32) {
+        __m256i bytes = _mm256_permute4x64_epi64(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(in)), 0xd8);
+        __m256i high = _mm256_shuffle_epi8(digits, _mm256_and_si256(_mm256_srli_epi16(bytes, 4), lowNibble));
+        __m256i low = _mm256_shuffle_epi8(digits, _mm256_and_si256(bytes, lowNibble));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), _mm256_unpacklo_epi8(high, low));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(out + 32), _mm256_unpackhi_epi8(high, low));
+    }
+    hexEncodeSsse3(in, n, out);
+}
+#endif
+
+struct HexBackend {
+    const char* name;
+    void (*encode)(const char*, size_t, char*);
+};
+
+/**
+ * Picks the hex encoder once per process - the widest one the CPU supports.
+ */
+const HexBackend& activeBackend() {
+    static const HexBackend backend = [] {
+#ifdef HEX_HAVE_SIMD
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            return HexBackend{"avx2", hexEncodeAvx2};
+        }
+        if (__builtin_cpu_supports("ssse3")) {
+            return HexBackend{"ssse3", hexEncodeSsse3};
+        }
+#endif
+        return HexBackend{"scalar", hexEncodeScalar};
+    }();
+    return backend;
+}
+
+} // namespace
+
+/**
+ * Encodes binary data as lowercase hexadecimal, two characters per input byte, one byte at a time.
+ * @param in The binary data to encode.
+ * @param n The number of bytes to encode.
+ * @param out The output buffer, which must hold at least 2 * n characters (no terminator is written).
+ */
+void hexEncodeScalar(const char* in, size_t n, char* out) {
+    for (size_t i = 0; i < n; ++i) {
+        auto byte = static_cast<unsigned char>(in[i]);
+        out[2 * i] = HEX_DIGITS[byte >> 4];
+        out[2 * i + 1] = HEX_DIGITS[byte & 0x0f];
+    }
+}
+
+/**
+ * Encodes binary data as lowercase hexadecimal using the fastest encoder the CPU supports.
+ * @param in The binary data to encode.
+ * @param n The number of bytes to encode.
+ * @param out The output buffer, which must hold at least 2 * n characters (no terminator is written).
+ */
+void hexEncode(const char* in, size_t n, char* out) {
+    activeBackend().encode(in, n, out);
+}
+
+/**
+ * Returns the name of the hex encoder hexEncode dispatches to on this CPU.
+ */
+const char* hexBackendName() {
+    return activeBackend().name;
+}
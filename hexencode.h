@@ -0,0 +1,16 @@
+/**
+ * Author: Erez Drutin
+ * Date: 16.10.2026
+ * Purpose: Serve as a header file for hexencode.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_HEXENCODE_H
+#define DEFENSIVE_MAMAN_15_HEXENCODE_H
+
+#include <cstddef>
+
+void hexEncode(const char* in, size_t n, char* out);
+void hexEncodeScalar(const char* in, size_t n, char* out);
+const char* hexBackendName();
+
+
+#endif //DEFENSIVE_MAMAN_15_HEXENCODE_H
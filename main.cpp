@@ -1,7 +1,18 @@
 #include "ProtocolHandler.h"
+#include "ParallelUploader.h"
+#include "AsyncSession.h"
+#include "AsyncProtocolHandler.h"
+#include "EventLoop.h"
+#include "ThreadPool.h"
 #include "FileHandler.h"
+#include "Base64Wrapper.h"
+#include "checksum.h"
 #include <iostream>
 #include <vector>
+#include <memory>
+#include <optional>
+#include <cstdlib>
+#include <climits>
 #include "Logger.h"
 
 
@@ -10,21 +21,27 @@
  * existing client information. If the MeInfo file exists, we will try to reconnect. If not, or if it exists but the
  * server isn't familiar with the user, we will try and register the user.
  * @param logger Reference to the Logger instance for logging.
+ * @param rotateKey Whether to replace the stored RSA pair with a new one when reconnecting.
+ * @param sessionCount The number of concurrent sessions to upload the files over.
  * @return True if the client operation was successful, false otherwise.
  */
-bool handleClient(Logger& logger) {
+bool handleClient(Logger& logger, bool rotateKey, unsigned int sessionCount) {
     FileHandler fileHandler;
     TransferInfo transferInfo = fileHandler.readTransferInfo();
+    if (sessionCount > 1 && transferInfo.filePaths.size() > 1) {
+        ParallelUploader uploader(std::move(transferInfo), sessionCount);
+        return uploader.run(rotateKey);
+    }
 
     try {
         MeInfo meInfo = fileHandler.readMeInfo();
-        ProtocolHandler protocolHandler(transferInfo.ipAddress, transferInfo.port, meInfo.name, transferInfo.filePath);
+        ProtocolHandler protocolHandler(transferInfo.ipAddress, transferInfo.port, meInfo.name, transferInfo.filePaths);
         if (protocolHandler.handleConnection()) {
-            return protocolHandler.handleReconnection();
+            return protocolHandler.handleReconnection(meInfo.base64Key, meInfo.keyType, rotateKey);
         }
     } catch (std::runtime_error &err) {
         // If reading MeInfo fails, assume new registration is needed.
-        ProtocolHandler protocolHandler(transferInfo.ipAddress, transferInfo.port, transferInfo.name, transferInfo.filePath);
+        ProtocolHandler protocolHandler(transferInfo.ipAddress, transferInfo.port, transferInfo.name, transferInfo.filePaths);
         if (protocolHandler.handleConnection()) {
             return protocolHandler.handleRegistration();
         }
@@ -33,11 +50,196 @@ bool handleClient(Logger& logger) {
     return false;
 }
 
-int main() {
+/**
+ * The coroutine counterpart of handleClient's flow - connects, then reconnects as the stored client or registers a
+ * new one.
+ * @param protocolHandler The handler to run the flows on.
+ * @param meInfo The stored client's information, or nullptr if there is none.
+ * @param rotateKey Whether to replace the stored key pair with a new one when reconnecting.
+ * @return True if the client operation was successful, false otherwise.
+ */
+Task<bool> runClientFlow(AsyncProtocolHandler& protocolHandler, const MeInfo* meInfo, bool rotateKey) {
+    // Awaited apart from the condition - GCC 12 miscompiles this flow with the co_await negated in it
+    bool connected = co_await protocolHandler.handleConnection();
+    if (!connected) {
+        co_return false;
+    }
+    if (meInfo) {
+        co_return co_await protocolHandler.handleReconnection(meInfo->base64Key, meInfo->keyType, rotateKey);
+    }
+    co_return co_await protocolHandler.handleRegistration();
+}
+
+/**
+ * Handles the client the same way handleClient does, running its flows as coroutines on an event loop - CPU heavy
+ * steps are awaited on a thread pool instead of blocking the flow.
+ * @param logger Reference to the Logger instance for logging.
+ * @param rotateKey Whether to replace the stored key pair with a new one when reconnecting.
+ * @return True if the client operation was successful, false otherwise.
+ */
+bool handleClientWithCoroutines(Logger& logger, bool rotateKey) {
+    FileHandler fileHandler;
+    TransferInfo transferInfo = fileHandler.readTransferInfo();
+    std::optional<MeInfo> meInfo;
+    try {
+        meInfo = fileHandler.readMeInfo();
+    } catch (std::runtime_error &err) {
+        logger.info("No stored client found, registering a new one");
+    }
+
+    EventLoop loop;
+    ThreadPool offloadPool;
+    ThreadPool segmentPool;
+    AsyncProtocolHandler protocolHandler(loop, offloadPool, segmentPool, transferInfo.ipAddress, transferInfo.port,
+                                         meInfo ? meInfo->name : transferInfo.name, transferInfo.filePaths);
+    Task<bool> flow = runClientFlow(protocolHandler, meInfo ? &*meInfo : nullptr, rotateKey);
+    flow.start();
+    loop.run();
+    return flow.done() && flow.result();
+}
+
+/**
+ * Drives many sessions from a single thread, each one an AsyncSession on a shared event loop, taking files from a
+ * shared queue. If the MeInfo file exists all the sessions reconnect as the stored client, otherwise each of them
+ * registers a client of its own (named after the transfer.info name and the session's number) - for load testing.
+ * @param logger Reference to the Logger instance for logging.
+ * @param transferInfo The server's address and the files to send.
+ * @param sessionCount The number of sessions to drive.
+ * @return True if every session sent every file it took, false otherwise.
+ */
+bool handleAsyncClients(Logger& logger, const TransferInfo& transferInfo, unsigned int sessionCount) {
+    FileHandler fileHandler;
+    std::string name = transferInfo.name;
+    std::string privateKey;
+    KeyType keyType = KeyType::RSA;
+    try {
+        MeInfo meInfo = fileHandler.readMeInfo();
+        name = meInfo.name;
+        privateKey = Base64Wrapper::decode(meInfo.base64Key);
+        keyType = meInfo.keyType;
+    } catch (std::exception&) {
+        logger.info("No stored client found, every session registers a client of its own");
+    }
+
+    EventLoop loop;
+    ThreadPool workerPool;
+    ThreadPool segmentPool;
+    size_t nextFile = 0;
+    auto fileSource = [&transferInfo, &nextFile](std::string& filePath) {
+        if (nextFile == transferInfo.filePaths.size()) {
+            return false;
+        }
+        filePath = transferInfo.filePaths[nextFile++];
+        return true;
+    };
+    std::vector<std::unique_ptr<AsyncSession>> sessions;
+    for (unsigned int i = 0; i < sessionCount; ++i) {
+        std::string sessionName = privateKey.empty() ? name + "_" + std::to_string(i) : name;
+        sessions.push_back(std::make_unique<AsyncSession>(loop, workerPool, segmentPool, transferInfo.ipAddress,
+                                                          transferInfo.port, sessionName, privateKey, keyType,
+                                                          fileSource, "AsyncSession-" + std::to_string(i)));
+        sessions.back()->start();
+    }
+    loop.run();
+
+    size_t succeeded = 0, filesSent = 0;
+    for (const auto& session : sessions) {
+        succeeded += session->succeeded() ? 1 : 0;
+        filesSent += session->filesSent();
+    }
+    logger.info((std::ostringstream() << succeeded << " of " << sessions.size() << " sessions succeeded, sending "
+                                      << filesSent << " of " << transferInfo.filePaths.size() << " files").str());
+    return succeeded == sessions.size();
+}
+
+/**
+ * Prints the client's command line usage.
+ * @param program The name the client was run as.
+ */
+void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [--rotate-key] [--sessions N | --coroutines]\n"
+              << "       " << program << " --async-sessions N\n"
+              << "  --rotate-key         Replace the stored key pair with a new one when reconnecting\n"
+              << "  --sessions N         Spread the files over N concurrent sessions\n"
+              << "  --coroutines         Run the flows as coroutines on an event loop\n"
+              << "  --async-sessions N   Drive N sessions from a single thread (reusing the stored key pair)"
+              << std::endl;
+}
+
+/**
+ * Reads the value of a count argument.
+ * @param value The argument's value, if it was given.
+ * @param count The count will be stored here.
+ * @return True if the value is a positive number, false otherwise.
+ */
+bool parseCount(const char* value, unsigned int& count) {
+    if (!value || *value < '0' || *value > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(value, &end, 10);
+    if (*end != '\0' || parsed == 0 || parsed > UINT_MAX) {
+        return false;
+    }
+    count = static_cast<unsigned int>(parsed);
+    return true;
+}
+
+int main(int argc, char* argv[]) {
     Logger logger("Main");
+    // Uploads are verified by their CRC alone, so don't run with a CRC backend that disagrees with cksum
+    if (!crcSelfTest()) {
+        logger.error((std::ostringstream() << "CRC self test failed for the " << crcBackendName()
+                                           << " backend. Shutting down...").str());
+        return 1;
+    }
+    logger.info((std::ostringstream() << "Using the " << crcBackendName() << " CRC backend").str());
+
+    // The stored RSA pair is reused on reconnection, unless explicitly asked to rotate it. The files are sent over a
+    // single session, unless asked to spread them over several concurrent ones:
+    bool rotateKey = false;
+    unsigned int sessionCount = 1;
+    unsigned int asyncSessionCount = 0;
+    bool useCoroutines = false;
+    bool sessionsGiven = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument(argv[i]);
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (argument == "--rotate-key") {
+            rotateKey = true;
+        } else if (argument == "--sessions" && parseCount(value, sessionCount)) {
+            sessionsGiven = true;
+            ++i;
+        } else if (argument == "--coroutines") {
+            useCoroutines = true;
+        } else if (argument == "--async-sessions" && parseCount(value, asyncSessionCount)) {
+            ++i;
+        } else {
+            bool isCount = argument == "--sessions" || argument == "--async-sessions";
+            std::cerr << "Error: " << (isCount ? "missing or invalid count for " : "unknown argument ") << argument
+                      << std::endl;
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    // The coroutine flow runs a single session, and the async sessions share the stored key pair - so they never
+    // replace it
+    if ((useCoroutines && sessionsGiven) ||
+        (asyncSessionCount > 0 && (rotateKey || sessionsGiven || useCoroutines))) {
+        std::cerr << "Error: incompatible arguments" << std::endl;
+        printUsage(argv[0]);
+        return 1;
+    }
 
     try {
-        bool status = handleClient(logger);
+        bool status;
+        if (asyncSessionCount > 0) {
+            status = handleAsyncClients(logger, FileHandler().readTransferInfo(), asyncSessionCount);
+        } else if (useCoroutines) {
+            status = handleClientWithCoroutines(logger, rotateKey);
+        } else {
+            status = handleClient(logger, rotateKey, sessionCount);
+        }
         if (status) {
             logger.info("Successfully finished client operation. Shutting down...");
         } else {
@@ -0,0 +1,661 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: A localhost stand-in for the server, speaking every protocol version the client does - the tests and
+ * benchmarks run the client's flows against it.
+ */
+#include "StandInServer.h"
+#include "AESWrapper.h"
+#include "RSAWrapper.h"
+#include "X25519Wrapper.h"
+#include "CryptoHandler.h"
+#include "WireFormat.h"
+#include "checksum.h"
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <system_error>
+
+namespace {
+    // Answers requests the stand-in doesn't understand - the client never expects it, so it fails the flow
+    constexpr uint16_t GENERAL_ERROR = 2107;
+
+    bool receiveAll(int socket, char* buffer, size_t length) {
+        while (length > 0) {
+            ssize_t received = recv(socket, buffer, length, 0);
+            if (received <= 0) {
+                if (received == -1 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            buffer += received;
+            length -= static_cast<size_t>(received);
+        }
+        return true;
+    }
+
+    bool sendAll(int socket, const char* buffer, size_t length) {
+#ifdef MSG_NOSIGNAL
+        const int flags = MSG_NOSIGNAL;
+#else
+        const int flags = 0;
+#endif
+        while (length > 0) {
+            ssize_t sent = send(socket, buffer, length, flags);
+            if (sent <= 0) {
+                if (sent == -1 && errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            buffer += sent;
+            length -= static_cast<size_t>(sent);
+        }
+        return true;
+    }
+
+    std::string randomBytes(size_t length) {
+        static thread_local std::random_device device;
+        std::string bytes(length, '\0');
+        for (char& c : bytes) {
+            c = static_cast<char>(device());
+        }
+        return bytes;
+    }
+
+    uint32_t loadBigEndian32(const char* in) {
+        auto* bytes = reinterpret_cast<const unsigned char*>(in);
+        return uint32_t(bytes[0]) << 24 | uint32_t(bytes[1]) << 16 | uint32_t(bytes[2]) << 8 | uint32_t(bytes[3]);
+    }
+
+    void storeBigEndian32(char* out, uint32_t value) {
+        for (int i = 0; i < 4; ++i) {
+            out[i] = static_cast<char>(value >> (24 - 8 * i));
+        }
+    }
+
+    // A null terminated field of a payload, cut at its size if it isn't terminated
+    std::string nameField(const char* field, size_t size) {
+        return {field, strnlen(field, size)};
+    }
+
+    // Multi-part uploads are told apart by their client and file name
+    std::string uploadKey(const char* clientId, const char* uploadPayload) {
+        return std::string(clientId, 16) + nameField(uploadPayload, WireFormat::UploadPayload::FileName::SIZE);
+    }
+
+    std::string hexDecode(const char* in, size_t length) {
+        auto nibble = [](char c) {
+            if (c >= '0' && c <= '9') return c - '0';
+            if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+            if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+            throw std::invalid_argument("content isn't hex encoded");
+        };
+        if (length % 2 != 0) {
+            throw std::invalid_argument("content isn't hex encoded");
+        }
+        std::string out(length / 2, '\0');
+        for (size_t i = 0; i < out.size(); ++i) {
+            out[i] = static_cast<char>(nibble(in[2 * i]) << 4 | nibble(in[2 * i + 1]));
+        }
+        return out;
+    }
+
+    /**
+     * Decrypts SEGMENTED_GCM content fed to it in pieces of any size (see ContentEncoding), authenticating every
+     * segment and checksumming the plaintext as it goes.
+     */
+    class GcmContentDecoder {
+    public:
+        GcmContentDecoder(const AESWrapper& cipher, uint64_t contentSize) : cipher_(cipher), contentSize_(contentSize) {}
+
+        // Returns false once the content is malformed, a segment fails authentication, or too much was fed
+        bool feed(const char* data, size_t length) {
+            if (failed_ || length > contentSize_ - fed_) {
+                failed_ = true;
+                return false;
+            }
+            fed_ += length;
+            pending_.insert(pending_.end(), data, data + length);
+            size_t consumed = 0;
+            if (!headerRead_ && pending_.size() >= GCM_CONTENT_HEADER_SIZE) {
+                segmentSize_ = loadBigEndian32(pending_.data());
+                std::memcpy(noncePrefix_, pending_.data() + 4, sizeof(noncePrefix_));
+                consumed = GCM_CONTENT_HEADER_SIZE;
+                segmentStart_ = GCM_CONTENT_HEADER_SIZE;
+                headerRead_ = true;
+                failed_ = segmentSize_ == 0;
+            }
+            while (headerRead_ && !failed_ && segmentStart_ < contentSize_) {
+                uint64_t segmentLength = std::min<uint64_t>(segmentSize_ + AESWrapper::GCM_TAG_LENGTH,
+                                                            contentSize_ - segmentStart_);
+                if (pending_.size() - consumed < segmentLength) {
+                    break;
+                }
+                failed_ = !decryptSegment(pending_.data() + consumed, static_cast<size_t>(segmentLength),
+                                          segmentStart_ + segmentLength == contentSize_);
+                consumed += segmentLength;
+                segmentStart_ += segmentLength;
+            }
+            pending_.erase(pending_.begin(), pending_.begin() + static_cast<std::ptrdiff_t>(consumed));
+            return !failed_;
+        }
+
+        bool done() const {
+            return !failed_ && headerRead_ && segmentStart_ == contentSize_;
+        }
+
+        uint32_t crc() const {
+            return crcFinalize(crc_);
+        }
+
+    private:
+        const AESWrapper& cipher_;
+        uint64_t contentSize_;
+        uint64_t fed_ = 0;
+        uint64_t segmentStart_ = 0;
+        uint32_t segmentSize_ = 0;
+        uint32_t index_ = 0;
+        unsigned char noncePrefix_[GCM_CONTENT_HEADER_SIZE - 4] = {};
+        bool headerRead_ = false;
+        bool failed_ = false;
+        std::vector<char> pending_;
+        std::vector<char> plain_;
+        CrcState crc_ = crcInit();
+
+        bool decryptSegment(const char* segment, size_t length, bool last) {
+            if (length < AESWrapper::GCM_TAG_LENGTH) {
+                return false;
+            }
+            size_t plainLength = length - AESWrapper::GCM_TAG_LENGTH;
+            unsigned char nonce[AESWrapper::GCM_NONCE_LENGTH];
+            std::memcpy(nonce, noncePrefix_, sizeof(noncePrefix_));
+            storeBigEndian32(reinterpret_cast<char*>(nonce) + sizeof(noncePrefix_), index_);
+            unsigned char aad[5];
+            storeBigEndian32(reinterpret_cast<char*>(aad), index_);
+            aad[4] = last ? 1 : 0;
+            plain_.resize(plainLength);
+            if (!cipher_.decryptGcm(nonce, aad, sizeof(aad), segment, plainLength,
+                                    reinterpret_cast<const unsigned char*>(segment + plainLength), plain_.data())) {
+                return false;
+            }
+            crcUpdate(crc_, plain_.data(), plainLength);
+            ++index_;
+            return true;
+        }
+    };
+}
+
+// Owns the key the upload was started under, so it can outlive the connection that started it
+struct StandInServer::Upload {
+    Upload(const std::string& aesKey, uint64_t contentSize)
+            : cipher(CryptoHandler::create_aes_cipher(aesKey)), contentSize(contentSize),
+              decoder(*cipher, contentSize) {}
+
+    std::unique_ptr<AESWrapper> cipher;
+    uint64_t contentSize;
+    uint64_t received = 0;
+    GcmContentDecoder decoder;
+};
+
+struct StandInServer::Session {
+    explicit Session(int socket) : socket(socket) {}
+
+    int socket;
+    char requestId[16] = {};  // The client id the current request was sent with
+    std::string aesKey;
+    std::unique_ptr<AESWrapper> cipher;
+    std::vector<char> payload;
+};
+
+StandInServer::StandInServer(Options options) : StandInServer(options, 0) {}
+
+/**
+ * Starts listening on a localhost port and accepting connections in the background.
+ * @param options How the server behaves.
+ * @param port The port to listen on, or 0 for any free port (see port()).
+ * @throws std::system_error If the port can't be listened on.
+ */
+StandInServer::StandInServer(Options options, int port) : options_(options) {
+    listen(port);
+    acceptor_ = std::thread(&StandInServer::acceptLoop, this);
+}
+
+/**
+ * Stops accepting connections, cuts the open ones and waits for every connection thread to finish.
+ */
+StandInServer::~StandInServer() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (int socket : sockets_) {
+            shutdown(socket, SHUT_RDWR);
+        }
+    }
+    shutdown(listener_, SHUT_RDWR);
+    acceptor_.join();
+    close(listener_);
+    for (std::thread& connection : connections_) {
+        connection.join();
+    }
+}
+
+int StandInServer::port() const {
+    return port_;
+}
+
+StandInServer::Stats StandInServer::stats() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+/**
+ * Forgets every registered client, as a server that lost its database would - reconnections are rejected from then on.
+ */
+void StandInServer::forgetClients() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    clients_.clear();
+}
+
+void StandInServer::listen(int port) {
+    listener_ = socket(AF_INET, SOCK_STREAM, 0);
+    if (listener_ == -1) {
+        throw std::system_error(errno, std::system_category(), "Failed to create the listening socket");
+    }
+    int reuse = 1;
+    setsockopt(listener_, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    sockaddr_in address{};
+    address.sin_family = AF_INET;
+    address.sin_port = htons(static_cast<uint16_t>(port));
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t length = sizeof(address);
+    if (bind(listener_, reinterpret_cast<sockaddr*>(&address), sizeof(address)) == -1 ||
+        ::listen(listener_, SOMAXCONN) == -1 ||
+        getsockname(listener_, reinterpret_cast<sockaddr*>(&address), &length) == -1) {
+        int error = errno;
+        close(listener_);
+        throw std::system_error(error, std::system_category(), "Failed to listen on localhost");
+    }
+    port_ = ntohs(address.sin_port);
+}
+
+void StandInServer::acceptLoop() {
+    while (true) {
+        int socket = accept(listener_, nullptr, nullptr);
+        if (socket == -1) {
+            if (errno == EINTR || errno == ECONNABORTED) {
+                continue;
+            }
+            return;  // The listener was shut down
+        }
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            close(socket);
+            return;
+        }
+        sockets_.insert(socket);
+        connections_.emplace_back(&StandInServer::serve, this, socket);
+    }
+}
+
+/**
+ * Serves a connection's requests one at a time, until the client disconnects or the server stops.
+ * @param socket The connection's socket.
+ */
+void StandInServer::serve(int socket) {
+    using namespace WireFormat;
+    Session session(socket);
+    char header[RequestHeader::SIZE];
+    while (receiveAll(socket, header, sizeof(header))) {
+        RequestHeader::ClientId::load(header, session.requestId);
+        auto version = static_cast<char>(RequestHeader::Version::load(header));
+        uint16_t code = RequestHeader::Code::load(header);
+        session.payload.resize(RequestHeader::PayloadSize::load(header));
+        if (!receiveAll(socket, session.payload.data(), session.payload.size())) {
+            break;
+        }
+        handle(session, code, version);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    sockets_.erase(socket);
+    close(socket);
+}
+
+void StandInServer::handle(Session& session, uint16_t code, char version) {
+    using namespace ServerRequests::Codes;
+    switch (code) {
+        case REGISTRATION:
+            onRegistration(session);
+            break;
+        case SEND_PUBLIC_KEY:
+        case SEND_X25519_PUBLIC_KEY:
+            onPublicKey(session, code == SEND_X25519_PUBLIC_KEY);
+            break;
+        case RECONNECT:
+            onReconnect(session);
+            break;
+        case SEND_FILE:
+            onSendFile(session, version);
+            break;
+        case BEGIN_FILE_UPLOAD:
+            onBeginUpload(session);
+            break;
+        case SEND_FILE_CHUNK:
+            onUploadChunk(session);
+            break;
+        case COMMIT_FILE_UPLOAD:
+            onCommitUpload(session);
+            break;
+        case RESUME_FILE_UPLOAD:
+            onResumeUpload(session);
+            break;
+        case CRC_CORRECT:
+        case CRC_INCORRECT_RESEND:
+        case CRC_INCORRECT_DONE:
+            onCrcStatus(session, code);
+            break;
+        default:
+            reply(session, GENERAL_ERROR, "");
+    }
+}
+
+void StandInServer::reply(Session& session, uint16_t code, const std::string& payload) {
+    using namespace WireFormat;
+    char header[ResponseHeader::SIZE];
+    ResponseHeader::Version::store(header, static_cast<uint8_t>(options_.version - '0'));
+    ResponseHeader::Code::store(header, code);
+    ResponseHeader::PayloadSize::store(header, static_cast<uint32_t>(payload.size()));
+    if (!sendAll(session.socket, header, sizeof(header)) || !sendAll(session.socket, payload.data(), payload.size())) {
+        shutdown(session.socket, SHUT_RDWR);
+    }
+}
+
+/**
+ * Generates the session's AES key, and wraps it for the client - with its RSA public key, or ECIES style with its
+ * X25519 public key.
+ * @param session The connection to use the key on.
+ * @param client The client to wrap the key for.
+ * @return The wrapped key, or an empty string if the client's public key is unusable.
+ */
+std::string StandInServer::issueAesKey(Session& session, const Client& client) {
+    session.aesKey = randomBytes(AESWrapper::DEFAULT_KEYLENGTH);
+    session.cipher = CryptoHandler::create_aes_cipher(session.aesKey);
+    try {
+        if (client.x25519) {
+            return X25519Wrapper::wrap(client.publicKey, session.aesKey);
+        }
+        RSAPublicWrapper rsa(client.publicKey);
+        return rsa.encrypt(session.aesKey);
+    } catch (const std::exception&) {
+        return "";
+    }
+}
+
+void StandInServer::onRegistration(Session& session) {
+    std::string name = nameField(session.payload.data(), session.payload.size());
+    std::string clientId = randomBytes(16);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [id, client] : clients_) {
+            if (client.name == name) {
+                clientId.clear();
+                break;
+            }
+        }
+        if (!clientId.empty()) {
+            clients_[clientId] = Client{name, "", false};
+            ++stats_.registrations;
+        }
+    }
+    if (clientId.empty()) {
+        reply(session, ServerResponses::REGISTRATION_FAILED, "");
+    } else {
+        reply(session, ServerResponses::REGISTRATION_SUCCESS, clientId);
+    }
+}
+
+void StandInServer::onPublicKey(Session& session, bool x25519) {
+    std::string clientId(session.requestId, 16);
+    Client client;
+    if (session.payload.size() > ServerRequests::Consts::NAME_FIELD_SIZE) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto found = clients_.find(clientId);
+        if (found != clients_.end()) {
+            found->second.publicKey.assign(session.payload.begin() + ServerRequests::Consts::NAME_FIELD_SIZE,
+                                           session.payload.end());
+            found->second.x25519 = x25519;
+            ++(x25519 ? stats_.x25519Keys : stats_.rsaKeys);
+            client = found->second;
+        }
+    }
+    std::string wrappedKey = client.publicKey.empty() ? "" : issueAesKey(session, client);
+    if (wrappedKey.empty()) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    reply(session, ServerResponses::RECEIVED_PUBLIC_KEY_SEND_AES, clientId + wrappedKey);
+}
+
+void StandInServer::onReconnect(Session& session) {
+    std::string name = nameField(session.payload.data(), session.payload.size());
+    std::string clientId;
+    Client client;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& [id, known] : clients_) {
+            if (known.name == name && !known.publicKey.empty()) {
+                clientId = id;
+                client = known;
+                break;
+            }
+        }
+        ++(clientId.empty() ? stats_.rejectedReconnections : stats_.reconnections);
+    }
+    std::string wrappedKey = clientId.empty() ? "" : issueAesKey(session, client);
+    if (wrappedKey.empty()) {
+        reply(session, ServerResponses::RECONNECT_REJECTED, std::string(16, '\0'));
+        return;
+    }
+    reply(session, ServerResponses::APPROVE_RECONNECT_SEND_AES, clientId + wrappedKey);
+}
+
+/**
+ * Decrypts a file sent in a single request, in the content encoding its request version stands for, and answers with
+ * the CRC of its plaintext. If asked to, cuts the connection instead of taking the file, as a failing network would.
+ */
+void StandInServer::onSendFile(Session& session, char version) {
+    const size_t fieldsSize = 4 + ServerRequests::Consts::NAME_FIELD_SIZE;
+    if (!session.cipher || session.payload.size() < fieldsSize ||
+        loadBigEndian32(session.payload.data()) != session.payload.size() - fieldsSize) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (options_.dropAfterUploads > 0 && stats_.uploads == options_.dropAfterUploads && !droppedConnection_) {
+            droppedConnection_ = true;
+            shutdown(session.socket, SHUT_RDWR);
+            return;
+        }
+    }
+    const char* name = session.payload.data() + 4;
+    const char* content = session.payload.data() + fieldsSize;
+    size_t contentSize = session.payload.size() - fieldsSize;
+    uint32_t crc = 0;
+    try {
+        if (version >= SEGMENTED_GCM_PROTOCOL_VERSION) {
+            GcmContentDecoder decoder(*session.cipher, contentSize);
+            if (!decoder.feed(content, contentSize) || !decoder.done()) {
+                throw std::runtime_error("content failed authentication");
+            }
+            crc = decoder.crc();
+        } else {
+            std::string cipherText = version >= BINARY_CONTENT_PROTOCOL_VERSION ? std::string(content, contentSize)
+                                                                                : hexDecode(content, contentSize);
+            std::string plain = session.cipher->decrypt(cipherText.data(), static_cast<unsigned int>(cipherText.size()));
+            crc = static_cast<uint32_t>(memcrc(plain.data(), plain.size()));
+        }
+    } catch (const std::exception&) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.uploads;
+        stats_.uploadedBytes += contentSize;
+    }
+    reply(session, ServerResponses::FILE_RECEIVED_CRC_OK, crcResponse(session, name, contentSize, crc));
+}
+
+/**
+ * Starts a multi-part upload of the file, replacing any upload of it the client had started before.
+ */
+void StandInServer::onBeginUpload(Session& session) {
+    using namespace WireFormat;
+    if (!session.cipher || session.payload.size() != UploadPayload::SIZE) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    auto upload = std::make_unique<Upload>(session.aesKey, UploadPayload::ContentSize::load(session.payload.data()));
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uploads_[uploadKey(session.requestId, session.payload.data())] = std::move(upload);
+    }
+    reply(session, ServerResponses::CONFIRM_MSG, std::string(session.requestId, 16));
+}
+
+/**
+ * Finds the upload a BEGIN / CHUNK / COMMIT request refers to. Only the connection sending an upload's requests
+ * touches it, so it is used outside the lock.
+ * @return The upload, or nullptr if the client hasn't started one for the file.
+ */
+StandInServer::Upload* StandInServer::findUpload(Session& session) {
+    using namespace WireFormat;
+    if (session.payload.size() < UploadPayload::SIZE) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto found = uploads_.find(uploadKey(session.requestId, session.payload.data()));
+    return found == uploads_.end() ? nullptr : found->second.get();
+}
+
+/**
+ * Decrypts a chunk of a multi-part upload - chunks must arrive in order, each starting where the last one ended. If
+ * asked to, cuts the connection instead of taking the chunk, as a failing network would.
+ */
+void StandInServer::onUploadChunk(Session& session) {
+    using namespace WireFormat;
+    Upload* upload = findUpload(session);
+    if (!upload || UploadPayload::ChunkOffset::load(session.payload.data()) != upload->received) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (options_.dropAfterChunks > 0 && stats_.chunks == options_.dropAfterChunks && !droppedConnection_) {
+            droppedConnection_ = true;
+            shutdown(session.socket, SHUT_RDWR);
+            return;
+        }
+    }
+    size_t length = session.payload.size() - UploadPayload::SIZE;
+    if (!upload->decoder.feed(session.payload.data() + UploadPayload::SIZE, length)) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    upload->received += length;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.chunks;
+    }
+    reply(session, ServerResponses::CONFIRM_MSG, std::string(session.requestId, 16));
+}
+
+/**
+ * Concludes a multi-part upload, answering with the CRC of its plaintext once every byte it announced has arrived.
+ */
+void StandInServer::onCommitUpload(Session& session) {
+    using namespace WireFormat;
+    Upload* upload = findUpload(session);
+    if (!upload || !upload->decoder.done() ||
+        UploadPayload::ContentSize::load(session.payload.data()) != upload->contentSize) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    uint32_t crc = upload->decoder.crc();
+    uint64_t contentSize = upload->contentSize;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        uploads_.erase(uploadKey(session.requestId, session.payload.data()));
+        ++stats_.uploads;
+        stats_.uploadedBytes += contentSize;
+    }
+    reply(session, ServerResponses::FILE_RECEIVED_CRC_OK, crcResponse(session, session.payload.data(), contentSize, crc));
+}
+
+/**
+ * Tells the client how much of an interrupted upload the server holds, so it can send the rest under the same key.
+ */
+void StandInServer::onResumeUpload(Session& session) {
+    using namespace WireFormat;
+    Upload* upload = findUpload(session);
+    if (!upload || UploadPayload::ContentSize::load(session.payload.data()) != upload->contentSize) {
+        reply(session, GENERAL_ERROR, "");
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        ++stats_.resumes;
+    }
+    char progress[UploadProgress::SIZE];
+    UploadProgress::ClientId::store(progress, session.requestId);
+    UploadProgress::ReceivedSize::store(progress, upload->received);
+    reply(session, ServerResponses::CONFIRM_MSG, std::string(progress, sizeof(progress)));
+}
+
+void StandInServer::onCrcStatus(Session& session, uint16_t code) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (code == ServerRequests::Codes::CRC_CORRECT) {
+            ++stats_.crcCorrect;
+        } else if (code == ServerRequests::Codes::CRC_INCORRECT_RESEND) {
+            ++stats_.crcResend;
+        } else {
+            ++stats_.crcDone;
+        }
+    }
+    reply(session, ServerResponses::CONFIRM_MSG, std::string(session.requestId, 16));
+}
+
+/**
+ * Builds a FILE_RECEIVED_CRC_OK payload - the first crcMismatches uploads of every file get a wrong CRC, to exercise
+ * the client's resend path.
+ * @param session The connection the file was received on.
+ * @param fileName The file's name field, NAME_FIELD_SIZE bytes long.
+ * @param contentSize The size of the file's encrypted content.
+ * @param crc The CRC of the file's plaintext.
+ * @return The payload: client id (16 bytes) | content size (4 bytes) | file name (255 bytes) | CRC (4 bytes).
+ */
+std::string StandInServer::crcResponse(Session& session, const char* fileName, uint64_t contentSize, uint32_t crc) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto mismatches = crcMismatchesLeft_.try_emplace(nameField(fileName, ServerRequests::Consts::NAME_FIELD_SIZE),
+                                                         options_.crcMismatches).first;
+        if (mismatches->second > 0) {
+            --mismatches->second;
+            crc = ~crc;
+        }
+    }
+    std::string payload(16 + 4 + ServerRequests::Consts::NAME_FIELD_SIZE + 4, '\0');
+    std::memcpy(&payload[0], session.requestId, 16);
+    storeBigEndian32(&payload[16], static_cast<uint32_t>(contentSize));
+    std::memcpy(&payload[20], fileName, ServerRequests::Consts::NAME_FIELD_SIZE);
+    std::memcpy(&payload[20 + ServerRequests::Consts::NAME_FIELD_SIZE], &crc, 4);  // Read back in host order
+    return payload;
+}
@@ -0,0 +1,103 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Serve as a header file for StandInServer.cpp
+ */
+#ifndef DEFENSIVE_MAMAN_15_STANDINSERVER_H
+#define DEFENSIVE_MAMAN_15_STANDINSERVER_H
+
+#include <atomic>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+#include "constants.h"
+
+// A stand-in for the server, listening on a localhost port: it registers clients, hands out AES keys wrapped with
+// their RSA or X25519 public key, decrypts uploaded files in every content encoding - sent whole or as a multi-part
+// upload - and answers with their CRC, so the client's flows can run end to end without the real server. Every
+// connection is served by a thread of its own.
+class StandInServer {
+public:
+    struct Options {
+        char version = PROTOCOL_VERSION;  // The protocol version the server advertises in its responses
+        unsigned int crcMismatches = 0;   // The number of uploads of each file answered with a wrong CRC at first
+        size_t dropAfterChunks = 0;       // Cuts the connection once, after acknowledging this many chunks (0: never)
+        size_t dropAfterUploads = 0;      // Cuts the connection once, after receiving this many whole files (0: never)
+    };
+
+    // What the server saw - a snapshot, taken by stats()
+    struct Stats {
+        size_t registrations = 0;
+        size_t rsaKeys = 0;
+        size_t x25519Keys = 0;
+        size_t reconnections = 0;
+        size_t rejectedReconnections = 0;
+        size_t uploads = 0;           // Files received in full, whatever their CRC
+        size_t chunks = 0;            // Multi-part upload chunks received
+        size_t resumes = 0;           // Multi-part uploads resumed
+        uint64_t uploadedBytes = 0;   // Encrypted content bytes received
+        size_t crcCorrect = 0;
+        size_t crcResend = 0;
+        size_t crcDone = 0;
+    };
+
+    explicit StandInServer(Options options);
+    StandInServer(Options options, int port);
+    ~StandInServer();
+    StandInServer(const StandInServer&) = delete;
+    StandInServer& operator=(const StandInServer&) = delete;
+
+    int port() const;
+    Stats stats();
+    void forgetClients();
+
+private:
+    struct Client {
+        std::string name;
+        std::string publicKey;
+        bool x25519 = false;
+    };
+
+    struct Session;  // The state of a single connection
+    struct Upload;   // A multi-part upload in progress
+
+    Options options_;
+    int listener_ = -1;
+    int port_ = 0;
+    std::atomic<bool> stopping_{false};
+    std::thread acceptor_;
+    std::vector<std::thread> connections_;
+    std::set<int> sockets_;
+    std::mutex mutex_;  // Guards everything below, and the members above that connections share
+    std::map<std::string, Client> clients_;     // By raw client id
+    std::map<std::string, unsigned int> crcMismatchesLeft_;  // By file name
+    std::map<std::string, std::unique_ptr<Upload>> uploads_;  // By raw client id and file name
+    bool droppedConnection_ = false;
+    Stats stats_;
+
+    void listen(int port);
+    void acceptLoop();
+    void serve(int socket);
+    void handle(Session& session, uint16_t code, char version);
+    void reply(Session& session, uint16_t code, const std::string& payload);
+    std::string issueAesKey(Session& session, const Client& client);
+    void onRegistration(Session& session);
+    void onPublicKey(Session& session, bool x25519);
+    void onReconnect(Session& session);
+    void onSendFile(Session& session, char version);
+    void onBeginUpload(Session& session);
+    void onUploadChunk(Session& session);
+    void onCommitUpload(Session& session);
+    void onResumeUpload(Session& session);
+    Upload* findUpload(Session& session);
+    void onCrcStatus(Session& session, uint16_t code);
+    std::string crcResponse(Session& session, const char* fileName, uint64_t contentSize, uint32_t crc);
+};
+
+
+#endif
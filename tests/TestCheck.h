@@ -0,0 +1,40 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: A minimal check macro shared by the test drivers - each driver is a plain executable run by ctest, failing
+ * if any of its checks failed.
+ */
+#ifndef DEFENSIVE_MAMAN_15_TESTCHECK_H
+#define DEFENSIVE_MAMAN_15_TESTCHECK_H
+
+#include <iostream>
+
+inline int& checkFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+// Reports a failed check along with its location, and carries on with the test
+#define CHECK(condition)                                                                                  \
+    do {                                                                                                  \
+        if (!(condition)) {                                                                               \
+            std::cerr << __FILE__ << ':' << __LINE__ << ": check failed: " << #condition << std::endl;   \
+            ++checkFailures();                                                                            \
+        }                                                                                                 \
+    } while (false)
+
+/**
+ * Gets the test's exit status, reporting the number of failed checks.
+ * @return 0 if every check passed, 1 otherwise.
+ */
+inline int testResult() {
+    if (checkFailures() == 0) {
+        std::cout << "All checks passed" << std::endl;
+        return 0;
+    }
+    std::cerr << checkFailures() << " checks failed" << std::endl;
+    return 1;
+}
+
+
+#endif
@@ -0,0 +1,114 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Run the coroutine flows of AsyncProtocolHandler against the stand-in server - registration with a CRC
+ * mismatch to resend after, reconnection with the stored key, and a connection dropped in the middle of the files.
+ */
+#include "StandInServer.h"
+#include "AsyncProtocolHandler.h"
+#include "FileHandler.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+
+/**
+ * Connects, then reconnects as the stored client or registers a new one.
+ * @param protocolHandler The handler to run the flows on.
+ * @param meInfo The stored client to reconnect as, or nullptr to register a new one.
+ * @return True if the flow was successful, false otherwise.
+ */
+Task<bool> clientFlow(AsyncProtocolHandler& protocolHandler, const MeInfo* meInfo) {
+    // Awaited apart from the condition - GCC 12 miscompiles this flow with the co_await negated in it
+    bool connected = co_await protocolHandler.handleConnection();
+    if (!connected) {
+        co_return false;
+    }
+    if (meInfo) {
+        co_return co_await protocolHandler.handleReconnection(meInfo->base64Key, meInfo->keyType);
+    }
+    co_return co_await protocolHandler.handleRegistration();
+}
+
+/**
+ * Runs a client flow on an event loop of its own, the way handleClientWithCoroutines does.
+ * @param port The server's port.
+ * @param name The client's name.
+ * @param filePaths The files to send.
+ * @param meInfo The stored client to reconnect as, or nullptr to register a new one.
+ * @return True if the flow was successful, false otherwise.
+ */
+bool runFlow(int port, const std::string& name, const std::vector<std::string>& filePaths, const MeInfo* meInfo) {
+    EventLoop loop;
+    ThreadPool offloadPool;
+    ThreadPool segmentPool;
+    AsyncProtocolHandler protocolHandler(loop, offloadPool, segmentPool, "127.0.0.1", port, name, filePaths);
+    Task<bool> flow = clientFlow(protocolHandler, meInfo);
+    flow.start();
+    loop.run();
+    CHECK(flow.done());
+    return flow.done() && flow.result();
+}
+
+/**
+ * Registers a client, which sends every file twice - the first CRC of each is wrong - then reconnects it with the
+ * key it stored, sending every file once.
+ * @param version The protocol version the server speaks.
+ * @param filePaths The files to send.
+ */
+void checkRegistrationAndReconnection(char version, const std::vector<std::string>& filePaths) {
+    std::cout << "Async flows against a version " << version << " server" << std::endl;
+    StandInServer server(StandInServer::Options{version, 1});
+    std::string name = std::string("async_flow_") + version;
+
+    CHECK(runFlow(server.port(), name, filePaths, nullptr));
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.registrations == 1);
+    CHECK(stats.uploads == 2 * filePaths.size());
+    CHECK(stats.crcResend == filePaths.size());
+    CHECK(stats.crcCorrect == filePaths.size());
+
+    MeInfo meInfo = FileHandler().readMeInfo();
+    CHECK(meInfo.name == name);
+    CHECK(runFlow(server.port(), meInfo.name, filePaths, &meInfo));
+    stats = server.stats();
+    CHECK(stats.registrations == 1);
+    CHECK(stats.reconnections == 1);
+    CHECK(stats.uploads == 3 * filePaths.size());
+    CHECK(stats.crcResend == filePaths.size());
+    CHECK(stats.crcCorrect == 2 * filePaths.size());
+    CHECK(stats.crcDone == 0);
+}
+
+int main() {
+    std::vector<std::string> filePaths;
+    for (int i = 0; i < 3; ++i) {
+        filePaths.push_back((std::filesystem::temp_directory_path() /
+                             ("async_flow_test_" + std::to_string(i) + ".txt")).string());
+        std::ofstream file(filePaths.back());
+        for (int line = 0; line < 20000 * (i + 1); ++line) {
+            file << "line " << line << " of file " << i << " sent by the async flow test\n";
+        }
+    }
+
+    for (char version : {PROTOCOL_VERSION, SEGMENTED_GCM_PROTOCOL_VERSION, X25519_KEY_EXCHANGE_PROTOCOL_VERSION}) {
+        checkRegistrationAndReconnection(version, filePaths);
+    }
+
+    // A connection lost after the first file fails the flow at once, without sending the remaining files
+    std::cout << "Async flow losing its connection" << std::endl;
+    StandInServer::Options options;
+    options.version = SEGMENTED_GCM_PROTOCOL_VERSION;
+    options.dropAfterUploads = 1;
+    StandInServer server(options);
+    CHECK(!runFlow(server.port(), "async_flow_dropped", filePaths, nullptr));
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.registrations == 1);
+    CHECK(stats.uploads == 1);
+    CHECK(stats.crcCorrect == 1);
+    CHECK(stats.crcResend + stats.crcDone == 0);
+
+    for (const std::string& filePath : filePaths) {
+        std::filesystem::remove(filePath);
+    }
+    return testResult();
+}
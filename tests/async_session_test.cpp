@@ -0,0 +1,145 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Drive several AsyncSessions on a single event loop against the stand-in server - sessions reconnecting as
+ * the stored client side by side with sessions registering clients of their own, under CRC mismatches - and check
+ * that sessions of the stored client fail, instead of registering it again or replacing its key, when the server
+ * rejects their reconnection or their stored key can't decrypt the AES key.
+ */
+#include "StandInServer.h"
+#include "AsyncSession.h"
+#include "ProtocolHandler.h"
+#include "FileHandler.h"
+#include "Base64Wrapper.h"
+#include "ThreadPool.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+
+// The client a session starts as - the stored one, or (with an empty private key) one it registers itself
+struct SessionIdentity {
+    std::string name;
+    std::string privateKey;
+    KeyType keyType;
+};
+
+/**
+ * Runs a session per identity side by side on a single event loop, the way handleAsyncClients does, all of them
+ * taking files from a shared queue.
+ * @param port The server's port.
+ * @param identities The clients the sessions start as.
+ * @param filePaths The files to send.
+ * @param filesSent The number of files the sessions sent will be stored here.
+ * @return Whether each session succeeded.
+ */
+std::vector<bool> runSessions(int port, const std::vector<SessionIdentity>& identities,
+                              const std::vector<std::string>& filePaths, size_t& filesSent) {
+    EventLoop loop;
+    ThreadPool workerPool;
+    ThreadPool segmentPool;
+    size_t nextFile = 0;
+    auto fileSource = [&filePaths, &nextFile](std::string& filePath) {
+        if (nextFile == filePaths.size()) {
+            return false;
+        }
+        filePath = filePaths[nextFile++];
+        return true;
+    };
+    std::vector<std::unique_ptr<AsyncSession>> sessions;
+    for (const SessionIdentity& identity : identities) {
+        sessions.push_back(std::make_unique<AsyncSession>(loop, workerPool, segmentPool, "127.0.0.1", port,
+                                                          identity.name, identity.privateKey, identity.keyType,
+                                                          fileSource, "AsyncSession-" + identity.name));
+        sessions.back()->start();
+    }
+    loop.run();
+
+    std::vector<bool> succeeded;
+    filesSent = 0;
+    for (const auto& session : sessions) {
+        succeeded.push_back(session->succeeded());
+        filesSent += session->filesSent();
+    }
+    return succeeded;
+}
+
+/**
+ * Registers the stored client, then runs its sessions with sessions registering clients of their own.
+ * @param version The protocol version the server speaks.
+ * @param filePaths The files to send.
+ */
+void checkSessions(char version, const std::vector<std::string>& filePaths) {
+    std::cout << "Async sessions against a version " << version << " server" << std::endl;
+    StandInServer server(StandInServer::Options{version, 1});
+    std::string name = std::string("async_session_") + version;
+    ProtocolHandler registration("127.0.0.1", server.port(), name, {filePaths[0]});
+    CHECK(registration.handleConnection());
+    CHECK(registration.handleRegistration());
+    MeInfo meInfo = FileHandler().readMeInfo();
+    SessionIdentity stored{meInfo.name, Base64Wrapper::decode(meInfo.base64Key), meInfo.keyType};
+    StandInServer::Stats before = server.stats();
+
+    // Every file is sent twice but the one the registration sent - the first CRC of each is wrong
+    size_t filesSent = 0;
+    std::vector<bool> succeeded = runSessions(server.port(), {stored, {name + "_0", "", KeyType::RSA}, stored,
+                                                              {name + "_1", "", KeyType::RSA}}, filePaths, filesSent);
+    for (bool sessionSucceeded : succeeded) {
+        CHECK(sessionSucceeded);
+    }
+    CHECK(filesSent == filePaths.size());
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.registrations - before.registrations == 2);
+    CHECK(stats.rsaKeys + stats.x25519Keys - before.rsaKeys - before.x25519Keys == 2);
+    CHECK(stats.reconnections - before.reconnections == 2);
+    CHECK(stats.uploads - before.uploads == 2 * filePaths.size() - 1);
+    CHECK(stats.crcResend - before.crcResend == filePaths.size() - 1);
+    CHECK(stats.crcCorrect - before.crcCorrect == filePaths.size());
+    CHECK(stats.crcDone == 0);
+
+    // A stored key that can't decrypt the AES key fails its session, without a new key pair being registered
+    before = server.stats();
+    SessionIdentity wrongKey = stored;
+    wrongKey.privateKey = std::string(stored.privateKey.size(), 'x');
+    succeeded = runSessions(server.port(), {wrongKey}, filePaths, filesSent);
+    CHECK(!succeeded[0]);
+    CHECK(filesSent == 0);
+    stats = server.stats();
+    CHECK(stats.reconnections - before.reconnections == 1);
+    CHECK(stats.rsaKeys + stats.x25519Keys == before.rsaKeys + before.x25519Keys);
+    CHECK(stats.uploads == before.uploads);
+
+    // A server that forgot the stored client rejects its sessions, and none of them falls back into registration -
+    // the session registering a client of its own sends every file
+    server.forgetClients();
+    before = server.stats();
+    succeeded = runSessions(server.port(), {stored, {name + "_2", "", KeyType::RSA}, stored}, filePaths, filesSent);
+    CHECK(!succeeded[0]);
+    CHECK(succeeded[1]);
+    CHECK(!succeeded[2]);
+    CHECK(filesSent == filePaths.size());
+    stats = server.stats();
+    CHECK(stats.rejectedReconnections - before.rejectedReconnections == 2);
+    CHECK(stats.registrations - before.registrations == 1);
+    CHECK(stats.crcCorrect - before.crcCorrect == filePaths.size());
+}
+
+int main() {
+    std::vector<std::string> filePaths;
+    for (int i = 0; i < 5; ++i) {
+        filePaths.push_back((std::filesystem::temp_directory_path() /
+                             ("async_session_test_" + std::to_string(i) + ".txt")).string());
+        std::ofstream file(filePaths.back());
+        for (int line = 0; line < 10000 * (i + 1); ++line) {
+            file << "line " << line << " of file " << i << " sent by the async session test\n";
+        }
+    }
+
+    for (char version : {PROTOCOL_VERSION, SEGMENTED_GCM_PROTOCOL_VERSION, X25519_KEY_EXCHANGE_PROTOCOL_VERSION}) {
+        checkSessions(version, filePaths);
+    }
+
+    for (const std::string& filePath : filePaths) {
+        std::filesystem::remove(filePath);
+    }
+    return testResult();
+}
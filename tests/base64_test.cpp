@@ -0,0 +1,106 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Check Base64Wrapper's codec against the RFC 4648 test vectors and a reference encoder, at every length
+ * around the vector kernels' strides, and check that malformed input is rejected.
+ */
+#include "Base64Wrapper.h"
+#include "TestCheck.h"
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+
+/**
+ * Encodes one character at a time - slow, but obviously right.
+ * @param plain The input.
+ * @return The padded Base64 text.
+ */
+std::string referenceEncode(const std::string& plain) {
+    const char alphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string encoded;
+    uint32_t bits = 0;
+    int count = 0;
+    for (unsigned char c : plain) {
+        bits = bits << 8 | c;
+        count += 8;
+        while (count >= 6) {
+            count -= 6;
+            encoded += alphabet[(bits >> count) & 0x3f];
+        }
+    }
+    if (count > 0) {
+        encoded += alphabet[(bits << (6 - count)) & 0x3f];
+    }
+    while (encoded.size() % 4 != 0) {
+        encoded += '=';
+    }
+    return encoded;
+}
+
+/**
+ * Checks whether decoding the text throws std::invalid_argument.
+ * @param encoded The text to decode.
+ * @return True if it was rejected.
+ */
+bool rejected(const std::string& encoded) {
+    try {
+        Base64Wrapper::decode(encoded);
+    } catch (const std::invalid_argument&) {
+        return true;
+    }
+    return false;
+}
+
+int main() {
+    std::cout << "Base64 backend: " << Base64Wrapper::backendName() << std::endl;
+
+    const char* vectors[][2] = {{"", ""}, {"f", "Zg=="}, {"fo", "Zm8="}, {"foo", "Zm9v"}, {"foob", "Zm9vYg=="},
+                                {"fooba", "Zm9vYmE="}, {"foobar", "Zm9vYmFy"}};
+    for (const auto& vector : vectors) {
+        CHECK(Base64Wrapper::encode(vector[0]) == vector[1]);
+        CHECK(Base64Wrapper::decode(vector[1]) == vector[0]);
+    }
+
+    // Every byte value, at every length around the SSSE3 and AVX2 strides
+    std::string data(700, '\0');
+    uint32_t seed = 0x2545f491;
+    for (size_t i = 0; i < data.size(); ++i) {
+        seed = seed * 1103515245 + 12345;
+        data[i] = static_cast<char>(i < 256 ? i : seed >> 16);
+    }
+    for (size_t length = 0; length < data.size(); ++length) {
+        std::string plain = data.substr(data.size() - length);
+        std::string encoded = Base64Wrapper::encode(plain);
+        CHECK(encoded == referenceEncode(plain));
+        CHECK(encoded.size() == Base64Wrapper::encodedLength(length));
+        CHECK(Base64Wrapper::decode(encoded) == plain);
+
+        // Decoding into a buffer of exactly maxDecodedLength, guarded to catch writes past it
+        std::string buffer(Base64Wrapper::maxDecodedLength(encoded.size()) + 32, '#');
+        size_t decoded = Base64Wrapper::decode(encoded.data(), encoded.size(), &buffer[0]);
+        CHECK(decoded == length);
+        CHECK(buffer.compare(0, length, plain) == 0);
+        CHECK(buffer.substr(Base64Wrapper::maxDecodedLength(encoded.size())) == std::string(32, '#'));
+    }
+
+    // Whitespace is skipped, even in the middle of a vector block, as in a line wrapped key or a me.info line
+    std::string encoded = Base64Wrapper::encode(data);
+    std::string wrapped;
+    for (size_t i = 0; i < encoded.size(); i += 64) {
+        wrapped += encoded.substr(i, 64) + "\r\n";
+    }
+    CHECK(Base64Wrapper::decode(wrapped) == data);
+    CHECK(Base64Wrapper::decode(" Zm9v\tYmFy\n") == "foobar");
+
+    // Malformed input, both in the vector blocks and in the scalar tail
+    std::string invalid = encoded;
+    invalid[40] = '*';
+    CHECK(rejected(invalid));
+    CHECK(rejected(encoded.substr(0, encoded.size() - 1)));
+    CHECK(rejected("Zm9v*mFy"));
+    CHECK(rejected("Z"));
+    CHECK(rejected("Zg=a"));
+    CHECK(rejected("Zg==="));
+    CHECK(rejected("="));
+    return testResult();
+}
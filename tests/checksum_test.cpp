@@ -0,0 +1,71 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Check the sliced and dispatched CRC kernels against the byte-wise reference loop, and the parallel file CRC
+ * against the serial one.
+ */
+#include "checksum.h"
+#include "TestCheck.h"
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+
+/**
+ * Fills a buffer with a fixed pseudo random sequence, so failures can be reproduced.
+ * @param size The buffer's size in bytes.
+ * @return The buffer.
+ */
+std::vector<char> sampleData(size_t size) {
+    std::vector<char> data(size);
+    uint32_t seed = 0x2545f491;
+    for (char& c : data) {
+        seed ^= seed << 13;
+        seed ^= seed >> 17;
+        seed ^= seed << 5;
+        c = static_cast<char>(seed);
+    }
+    return data;
+}
+
+int main() {
+    std::cout << "CRC backend: " << crcBackendName() << std::endl;
+    CHECK(crcSelfTest());
+
+    char check[] = "123456789";
+    CHECK(memcrc(check, 9) == 930766865UL);
+    CHECK(memcrcSlice8(check, 9) == 930766865UL);
+    CHECK(memcrcSlice16(check, 9) == 930766865UL);
+    CHECK(memcrc(check, 0) == memcrcBytewise(check, 0));
+
+    // Every length around the kernels' strides, from every start alignment, and a few larger buffers
+    std::vector<char> data = sampleData((size_t(1) << 20) + 4096);
+    for (size_t offset = 0; offset < 16; ++offset) {
+        for (size_t length = 0; length <= 1024; ++length) {
+            unsigned long expected = memcrcBytewise(data.data() + offset, length);
+            CHECK(memcrcSlice8(data.data() + offset, length) == expected);
+            CHECK(memcrcSlice16(data.data() + offset, length) == expected);
+            CHECK(memcrc(data.data() + offset, length) == expected);
+        }
+    }
+    for (size_t length : {size_t(4093), size_t(65536), size_t(65537), data.size() - 3}) {
+        unsigned long expected = memcrcBytewise(data.data() + 3, length);
+        CHECK(memcrcSlice8(data.data() + 3, length) == expected);
+        CHECK(memcrcSlice16(data.data() + 3, length) == expected);
+        CHECK(memcrc(data.data() + 3, length) == expected);
+    }
+
+    // Files split into ranges checksummed in parallel, with a range size that doesn't divide the file
+    std::vector<char> fileData = sampleData(3 * CRC_PARALLEL_MIN_RANGE + 12345);
+    std::string path = (std::filesystem::temp_directory_path() / "checksum_test.bin").string();
+    std::ofstream(path, std::ios::binary).write(fileData.data(), static_cast<std::streamsize>(fileData.size()));
+    uint32_t expected = memcrcBytewise(fileData.data(), fileData.size());
+    CHECK(readCrc(path) == expected);
+    for (unsigned int threads = 1; threads <= 8; ++threads) {
+        CHECK(readCrcParallel(path, threads) == expected);
+    }
+    std::ofstream(path, std::ios::binary | std::ios::trunc).close();
+    CHECK(readCrcParallel(path, 4) == memcrcBytewise(fileData.data(), 0));
+    std::filesystem::remove(path);
+    return testResult();
+}
@@ -0,0 +1,65 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Send a file large enough for a multi-part upload (BEGIN / CHUNK / COMMIT) to the stand-in server, which
+ * answers its first commit with a wrong CRC, and check the upload is sent again in full and then verified.
+ */
+#include "StandInServer.h"
+#include "ProtocolHandler.h"
+#include "FileHandler.h"
+#include "CryptoHandler.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+
+/**
+ * Writes a file of pseudo random bytes.
+ * @param path The file's path.
+ * @param size The file's size in bytes.
+ */
+void writeSampleFile(const std::string& path, size_t size) {
+    std::vector<char> block(size_t(1) << 20);
+    uint32_t seed = 1;
+    std::ofstream file(path, std::ios::binary);
+    for (size_t written = 0; written < size; written += block.size()) {
+        for (char& c : block) {
+            seed = seed * 1103515245 + 12345;
+            c = static_cast<char>(seed >> 16);
+        }
+        file.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), size - written)));
+    }
+}
+
+int main() {
+    // A size that leaves the last chunk short, and its last segment partial
+    size_t largeSize = ProtocolHandler::CHUNKED_UPLOAD_MIN_FILE_SIZE + 5 * GCM_SEGMENT_SIZE + 12345;
+    std::string largePath = (std::filesystem::temp_directory_path() / "chunked_upload_test.bin").string();
+    std::string smallPath = (std::filesystem::temp_directory_path() / "chunked_upload_test.txt").string();
+    writeSampleFile(largePath, largeSize);
+    writeSampleFile(smallPath, 100000);
+
+    StandInServer server(StandInServer::Options{CHUNKED_UPLOAD_PROTOCOL_VERSION, 1});
+    ProtocolHandler protocolHandler("127.0.0.1", server.port(), "chunked_upload", {largePath, smallPath});
+    CHECK(protocolHandler.handleConnection());
+    CHECK(protocolHandler.handleRegistration());
+
+    // Both files are sent twice - the first CRC of each is wrong - but only the large one in chunks
+    size_t segments = CryptoHandler::gcm_segment_count(largeSize);
+    size_t chunks = (segments + ProtocolHandler::UPLOAD_CHUNK_SEGMENTS - 1) / ProtocolHandler::UPLOAD_CHUNK_SEGMENTS;
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.uploads == 4);
+    CHECK(stats.chunks == 2 * chunks);
+    CHECK(stats.crcResend == 2);
+    CHECK(stats.crcCorrect == 2);
+    CHECK(stats.crcDone == 0);
+    CHECK(stats.uploadedBytes == 2 * CryptoHandler::encrypted_content_size(largeSize, ContentEncoding::SEGMENTED_GCM) +
+                                 2 * CryptoHandler::encrypted_content_size(100000, ContentEncoding::SEGMENTED_GCM));
+
+    // A concluded upload leaves no journal behind
+    UploadJournal journal;
+    CHECK(!FileHandler().readUploadJournal(largePath, journal));
+
+    std::filesystem::remove(largePath);
+    std::filesystem::remove(smallPath);
+    return testResult();
+}
@@ -0,0 +1,64 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Run the registration and reconnection flows against the stand-in server, with an RSA key exchange (under
+ * each content encoding) and with an X25519 one, checking that the stored key of either type is reused on reconnection.
+ */
+#include "StandInServer.h"
+#include "ProtocolHandler.h"
+#include "FileHandler.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+
+/**
+ * Registers a client, then reconnects it with the key it stored, sending the file both times.
+ * @param version The protocol version the server speaks.
+ * @param filePath The file to send.
+ */
+void checkKeyExchange(char version, const std::string& filePath) {
+    std::cout << "Key exchange against a version " << version << " server" << std::endl;
+    StandInServer server(StandInServer::Options{version, 0});
+    std::string name = std::string("key_exchange_") + version;
+    bool x25519 = version >= X25519_KEY_EXCHANGE_PROTOCOL_VERSION;
+
+    ProtocolHandler registration("127.0.0.1", server.port(), name, {filePath});
+    CHECK(registration.handleConnection());
+    CHECK(registration.handleRegistration());
+    MeInfo meInfo = FileHandler().readMeInfo();
+    CHECK(meInfo.name == name);
+    CHECK(meInfo.keyType == (x25519 ? KeyType::X25519 : KeyType::RSA));
+    std::ifstream privateKeyFile(std::string(CLIENTS_BASE_PATH) + PRIVATE_KEY_FILE);
+    std::string keyTypeLine;
+    std::getline(privateKeyFile, keyTypeLine);
+    CHECK(keyTypeLine == (x25519 ? "X25519" : "RSA"));
+
+    ProtocolHandler reconnection("127.0.0.1", server.port(), meInfo.name, {filePath});
+    CHECK(reconnection.handleConnection());
+    CHECK(reconnection.handleReconnection(meInfo.base64Key, meInfo.keyType));
+
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.registrations == 1);
+    CHECK(stats.x25519Keys == (x25519 ? 1 : 0));
+    CHECK(stats.rsaKeys == (x25519 ? 0 : 1));
+    CHECK(stats.reconnections == 1);
+    CHECK(stats.uploads == 2);
+    CHECK(stats.crcCorrect == 2);
+    CHECK(stats.crcResend == 0);
+}
+
+int main() {
+    std::string filePath = (std::filesystem::temp_directory_path() / "key_exchange_test.txt").string();
+    std::ofstream file(filePath);
+    for (int i = 0; i < 10000; ++i) {
+        file << "line " << i << " of the file sent by the key exchange test\n";
+    }
+    file.close();
+
+    for (char version : {PROTOCOL_VERSION, BINARY_CONTENT_PROTOCOL_VERSION, SEGMENTED_GCM_PROTOCOL_VERSION,
+                         X25519_KEY_EXCHANGE_PROTOCOL_VERSION}) {
+        checkKeyExchange(version, filePath);
+    }
+    std::filesystem::remove(filePath);
+    return testResult();
+}
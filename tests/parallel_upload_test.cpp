@@ -0,0 +1,54 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Upload files over several concurrent sessions to the stand-in server, and check that sessions whose
+ * reconnection is rejected fail without registering the client again or rewriting me.info.
+ */
+#include "StandInServer.h"
+#include "ParallelUploader.h"
+#include "FileHandler.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+
+int main() {
+    const unsigned int sessions = 4;
+    std::vector<std::string> filePaths;
+    for (int i = 0; i < 6; ++i) {
+        filePaths.push_back((std::filesystem::temp_directory_path() /
+                             ("parallel_upload_test_" + std::to_string(i) + ".txt")).string());
+        std::ofstream file(filePaths.back());
+        for (int line = 0; line < 5000 * (i + 1); ++line) {
+            file << "line " << line << " of file " << i << '\n';
+        }
+    }
+    std::string meInfoPath = std::string(CLIENTS_BASE_PATH) + ME_INFO_FILE_NAME;
+    std::filesystem::remove(meInfoPath);
+
+    // The client is registered once, then every session reconnects with the stored key
+    StandInServer server(StandInServer::Options{SEGMENTED_GCM_PROTOCOL_VERSION, 0});
+    TransferInfo transferInfo{"127.0.0.1", server.port(), "parallel_upload", filePaths};
+    CHECK(ParallelUploader(transferInfo, sessions).run(false));
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.registrations == 1);
+    CHECK(stats.rsaKeys + stats.x25519Keys == 1);
+    CHECK(stats.reconnections == sessions);
+    CHECK(stats.uploads == filePaths.size());
+    CHECK(stats.crcCorrect == filePaths.size());
+
+    // A server that forgot the client rejects every session, and none of them falls back into registration
+    std::string meInfo = FileHandler().readFileContents(meInfoPath);
+    server.forgetClients();
+    CHECK(!ParallelUploader(transferInfo, sessions).run(false));
+    stats = server.stats();
+    CHECK(stats.registrations == 1);
+    CHECK(stats.rsaKeys + stats.x25519Keys == 1);
+    CHECK(stats.rejectedReconnections == sessions);
+    CHECK(stats.uploads == filePaths.size());
+    CHECK(FileHandler().readFileContents(meInfoPath) == meInfo);
+
+    for (const std::string& filePath : filePaths) {
+        std::filesystem::remove(filePath);
+    }
+    return testResult();
+}
@@ -0,0 +1,104 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Cut the connection in the middle of a multi-part upload, check the client gives up without retrying and
+ * keeps its upload journal, then check the next run resumes the upload from the journal and concludes it - unless the
+ * file changed in between, in which case the upload starts over.
+ */
+#include "StandInServer.h"
+#include "ProtocolHandler.h"
+#include "FileHandler.h"
+#include "CryptoHandler.h"
+#include "AESWrapper.h"
+#include "TestCheck.h"
+#include <filesystem>
+#include <fstream>
+
+int main() {
+    const size_t acknowledgedChunks = 3;
+    size_t fileSize = ProtocolHandler::CHUNKED_UPLOAD_MIN_FILE_SIZE + 3 * GCM_SEGMENT_SIZE + 777;
+    std::string filePath = (std::filesystem::temp_directory_path() / "resume_upload_test.bin").string();
+    {
+        std::vector<char> block(GCM_SEGMENT_SIZE);
+        uint32_t seed = 7;
+        std::ofstream file(filePath, std::ios::binary);
+        for (size_t written = 0; written < fileSize; written += block.size()) {
+            for (char& c : block) {
+                seed = seed * 1103515245 + 12345;
+                c = static_cast<char>(seed >> 16);
+            }
+            file.write(block.data(), static_cast<std::streamsize>(std::min(block.size(), fileSize - written)));
+        }
+    }
+
+    StandInServer::Options options;
+    options.version = CHUNKED_UPLOAD_PROTOCOL_VERSION;
+    options.dropAfterChunks = acknowledgedChunks;
+    StandInServer server(options);
+
+    // The first run loses its connection mid-upload
+    ProtocolHandler interrupted("127.0.0.1", server.port(), "resume_upload", {filePath});
+    CHECK(interrupted.handleConnection());
+    CHECK(!interrupted.handleRegistration());
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.chunks == acknowledgedChunks);
+    CHECK(stats.uploads == 0);
+    CHECK(stats.crcResend + stats.crcDone + stats.crcCorrect == 0);
+
+    FileHandler fileHandler;
+    UploadJournal journal;
+    CHECK(fileHandler.readUploadJournal(filePath, journal));
+    CHECK(journal.nextSegment == acknowledgedChunks * ProtocolHandler::UPLOAD_CHUNK_SEGMENTS);
+    CHECK(journal.offset == GCM_CONTENT_HEADER_SIZE +
+                            journal.nextSegment * (GCM_SEGMENT_SIZE + AESWrapper::GCM_TAG_LENGTH));
+
+    // The next run reconnects and sends only what wasn't acknowledged
+    MeInfo meInfo = fileHandler.readMeInfo();
+    ProtocolHandler resumed("127.0.0.1", server.port(), meInfo.name, {filePath});
+    CHECK(resumed.handleConnection());
+    CHECK(resumed.handleReconnection(meInfo.base64Key, meInfo.keyType));
+    size_t segments = CryptoHandler::gcm_segment_count(fileSize);
+    size_t chunks = (segments + ProtocolHandler::UPLOAD_CHUNK_SEGMENTS - 1) / ProtocolHandler::UPLOAD_CHUNK_SEGMENTS;
+    stats = server.stats();
+    CHECK(stats.resumes == 1);
+    CHECK(stats.chunks == chunks);
+    CHECK(stats.uploads == 1);
+    CHECK(stats.crcCorrect == 1);
+    CHECK(!fileHandler.readUploadJournal(filePath, journal));
+
+    // A changed file is never resumed - neither one rewritten in place with its size and modification time kept, nor
+    // one whose acknowledged content no longer matches the journal's CRC
+    for (bool rewritten : {true, false}) {
+        StandInServer cutServer(options);
+        ProtocolHandler cut("127.0.0.1", cutServer.port(), "resume_upload", {filePath});
+        CHECK(cut.handleConnection());
+        CHECK(!cut.handleRegistration());
+        CHECK(fileHandler.readUploadJournal(filePath, journal));
+        if (rewritten) {
+            auto modified = std::filesystem::last_write_time(filePath);
+            std::fstream file(filePath, std::ios::in | std::ios::out | std::ios::binary);
+            char first = static_cast<char>(file.get());
+            file.seekp(0);
+            file.put(static_cast<char>(~first));
+            file.close();
+            std::filesystem::last_write_time(filePath, modified);
+        } else {
+            journal.crc = ~journal.crc;
+            fileHandler.saveUploadJournal(journal);
+        }
+
+        meInfo = fileHandler.readMeInfo();
+        ProtocolHandler restarted("127.0.0.1", cutServer.port(), meInfo.name, {filePath});
+        CHECK(restarted.handleConnection());
+        CHECK(restarted.handleReconnection(meInfo.base64Key, meInfo.keyType));
+        stats = cutServer.stats();
+        CHECK(stats.resumes == 0);
+        CHECK(stats.chunks == acknowledgedChunks + chunks);
+        CHECK(stats.uploads == 1);
+        CHECK(stats.crcCorrect == 1);
+        CHECK(!fileHandler.readUploadJournal(filePath, journal));
+    }
+
+    std::filesystem::remove(filePath);
+    return testResult();
+}
@@ -0,0 +1,32 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Run the stand-in server on its own, to point a client built from main.cpp at it by hand.
+ * Usage: stand_in_server [--version V] [--crc-mismatches N] [port, default 8080]
+ */
+#include "StandInServer.h"
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+int main(int argc, char* argv[]) {
+    StandInServer::Options options;
+    int port = 8080;
+    for (int i = 1; i < argc; ++i) {
+        std::string argument(argv[i]);
+        if (argument == "--version" && i + 1 < argc) {
+            options.version = argv[++i][0];
+        } else if (argument == "--crc-mismatches" && i + 1 < argc) {
+            options.crcMismatches = static_cast<unsigned int>(std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            port = std::atoi(argv[i]);
+        }
+    }
+
+    StandInServer server(options, port);
+    std::cout << "Stand-in server speaking version " << options.version << " on port " << server.port() << std::endl;
+    while (true) {
+        pause();
+    }
+}
@@ -0,0 +1,58 @@
+/**
+ * Author: Erez Drutin
+ * Date: 17.10.2026
+ * Purpose: Send a file to stand-in servers answering its first 0, 5 and 15 uploads with a wrong CRC, and check the
+ * resends reuse the payload - the session's payload arena makes as many heap allocations however often it resends.
+ */
+#include "StandInServer.h"
+#include "ProtocolHandler.h"
+#include "TestCheck.h"
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+/**
+ * Registers a client, which sends the file, against a server answering its first uploads with a wrong CRC.
+ * @param crcMismatches The number of uploads answered with a wrong CRC.
+ * @param filePath The file to send.
+ * @return The number of heap allocations the session's payload arena made for the upload.
+ */
+size_t uploadAllocations(unsigned int crcMismatches, const std::string& filePath) {
+    std::cout << "Upload with " << crcMismatches << " CRC mismatches" << std::endl;
+    StandInServer::Options options;
+    options.version = SEGMENTED_GCM_PROTOCOL_VERSION;
+    options.crcMismatches = crcMismatches;
+    StandInServer server(options);
+
+    ProtocolHandler protocolHandler("127.0.0.1", server.port(), "upload_allocations_" + std::to_string(crcMismatches),
+                                    {filePath});
+    size_t heapAllocations = protocolHandler.payloadHeapAllocations();
+    CHECK(protocolHandler.handleConnection());
+    // The client sends a file up to 3 times before giving up on it
+    CHECK(protocolHandler.handleRegistration() == (crcMismatches < 3));
+
+    unsigned int resends = std::min(crcMismatches, 3u);
+    StandInServer::Stats stats = server.stats();
+    CHECK(stats.uploads == (crcMismatches < 3 ? resends + 1 : resends));
+    CHECK(stats.crcResend == resends);
+    CHECK(stats.crcCorrect == (crcMismatches < 3 ? 1 : 0));
+    CHECK(stats.crcDone == (crcMismatches < 3 ? 0 : 1));
+    return protocolHandler.payloadHeapAllocations() - heapAllocations;
+}
+
+int main() {
+    std::string filePath = (std::filesystem::temp_directory_path() / "upload_allocations_test.txt").string();
+    std::ofstream file(filePath);
+    for (int i = 0; i < 50000; ++i) {
+        file << "line " << i << " of the file sent by the upload allocations test\n";
+    }
+    file.close();
+
+    size_t withoutMismatches = uploadAllocations(0, filePath);
+    CHECK(withoutMismatches > 0);
+    CHECK(uploadAllocations(5, filePath) == withoutMismatches);
+    CHECK(uploadAllocations(15, filePath) == withoutMismatches);
+
+    std::filesystem::remove(filePath);
+    return testResult();
+}